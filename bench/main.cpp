@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifndef _WIN32
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+extern char** environ;
+#endif
+
+#include "deps/fmt.hpp"
+#include "encode.hpp"
+#include "syringe.hpp"
+
+using namespace std;
+
+/// Run `function` repeatedly for at least `min_duration` and return throughput in GB/s of `bytes` per call.
+template<typename F>
+double measure_throughput(std::size_t bytes, F&& function, chrono::duration<double> min_duration = 1s) {
+	using clock = chrono::steady_clock;
+
+	function();  // Warm up caches and page in buffers
+
+	std::size_t iterations = 0;
+	auto start = clock::now();
+	chrono::duration<double> elapsed{};
+	do {
+		function();
+		++iterations;
+		elapsed = clock::now() - start;
+	} while (elapsed < min_duration);
+
+	return static_cast<double>(bytes * iterations) / elapsed.count() / 1e9;
+}
+
+void bench_decimal_encoders() {
+	constexpr std::size_t size = 16 * 1024 * 1024;
+
+	vector<uint8_t> random_data(size);
+	mt19937 engine(42);
+	uniform_int_distribution<int> distribution(0, 255);
+	for (auto& byte : random_data) byte = static_cast<uint8_t>(distribution(engine));
+
+	vector<uint8_t> null_data(size, 0);
+
+	vector<pair<string_view, decimal_encoder_t>> encoders = {{"scalar", encode_decimal_scalar}};
+#if SYRINGE_X86
+	if (cpu_supports(cpu_feature::sse41)) encoders.emplace_back("sse4.1", encode_decimal_sse41);
+	if (cpu_supports(cpu_feature::avx2)) encoders.emplace_back("avx2", encode_decimal_avx2);
+#endif
+
+	string output(decimal_size_bound(size), '\0');
+
+	fmt::print("Decimal encoding ({} MiB input):\n", size / 1024 / 1024);
+	for (auto [name, encoder] : encoders) {
+		double random_gbps = measure_throughput(size, [&]() { encoder(random_data, output.data()); });
+		double null_gbps = measure_throughput(size, [&]() { encoder(null_data, output.data()); });
+
+		fmt::print("  {:<8} random: {:6.2f} GB/s   null: {:6.2f} GB/s\n", name, random_gbps, null_gbps);
+	}
+}
+
+struct compile_result_t {
+	double seconds = -1;      ///< Wall time, negative if compilation failed
+	double peak_rss_mib = -1;  ///< Peak resident set size of the compiler, negative if unknown
+};
+
+/// Compile `path` once without generating code and measure the time and memory it took.
+compile_result_t measure_compile(const filesystem::path& path) {
+#ifdef _MSC_VER
+	string command = fmt::format(R"("{}" /nologo /std:c++20 /Zs "{}")", SYRINGE_BENCH_CXX, path.string());
+#else
+	string command = fmt::format(R"("{}" -std=c++20 -fsyntax-only "{}")", SYRINGE_BENCH_CXX, path.string());
+#endif
+
+	compile_result_t result;
+	auto start = chrono::steady_clock::now();
+
+#ifdef _WIN32
+	if (std::system(command.c_str()) != 0) return result;
+#else
+	// Usage of a waited-for child includes its own waited-for children, which covers the compiler behind the driver
+	const char* argv[] = {"sh", "-c", command.c_str(), nullptr};
+	pid_t pid;
+	if (posix_spawnp(&pid, "sh", nullptr, nullptr, const_cast<char* const*>(argv), environ) != 0) return result;
+
+	int status;
+	rusage usage;
+	if (wait4(pid, &status, 0, &usage) != pid or not WIFEXITED(status) or WEXITSTATUS(status) != 0) return result;
+	result.peak_rss_mib = static_cast<double>(usage.ru_maxrss) / 1024;  // Kilobytes on Linux
+#endif
+
+	result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+void bench_compile_time() {
+	constexpr std::size_t size = 4 * 1024 * 1024;
+
+	filesystem::path directory = filesystem::temp_directory_path() / "syringe_benchmarks";
+	filesystem::create_directories(directory);
+
+	vector<uint8_t> data(size);
+	mt19937 engine(42);
+	uniform_int_distribution<int> distribution(0, 255);
+	for (auto& byte : data) byte = static_cast<uint8_t>(distribution(engine));
+
+	filesystem::path input = directory / "random.bin";
+	FILE* fp = std::fopen(input.string().c_str(), "wb");
+	std::fwrite(data.data(), 1, data.size(), fp);
+	std::fclose(fp);
+
+	InputConfig base_config{.paths = {{input.string(), "random.bin"}}, .variable_name = "resources"};
+	vector<pair<string_view, InputConfig>> configs = {{"decimal", base_config}};
+	configs.emplace_back("decimal, wrap 16", base_config).second.wrap = 16;
+	configs.emplace_back("string", base_config).second.encoding = encoding_t::string;
+	configs.emplace_back("words", base_config).second.encoding = encoding_t::words;
+
+	fmt::print("Compile time ({} MiB random input, {}):\n", size / 1024 / 1024, SYRINGE_BENCH_CXX);
+	for (std::size_t i = 0; i < configs.size(); ++i) {
+		auto& [name, config] = configs[i];
+
+		filesystem::path output = directory / fmt::format("output_{}.cpp", i);
+		fp = std::fopen(output.string().c_str(), "wb");
+		syringe(config, fp);
+		std::fclose(fp);
+
+		string text = syringe(config);
+		std::size_t longest_line = 0;
+		for (std::size_t first = 0, last = 0; first < text.size(); first = last + 1) {
+			last = std::min(text.find('\n', first), text.size());
+			longest_line = std::max(longest_line, last - first);
+		}
+
+		compile_result_t result = measure_compile(output);
+		fmt::print(
+			"  {:<17} {:6.1f} MiB, longest line {:>9} chars: {:6.2f} s, {:7.0f} MiB peak RSS\n",
+			name,
+			static_cast<double>(filesystem::file_size(output)) / 1024 / 1024,
+			longest_line,
+			result.seconds,
+			result.peak_rss_mib
+		);
+	}
+
+	filesystem::remove_all(directory);
+}
+
+int main() {
+	bench_decimal_encoders();
+	bench_compile_time();
+}
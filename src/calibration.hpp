@@ -0,0 +1,164 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "deps/fmt.hpp"
+
+#include "cli.hpp"
+#include "input.hpp"
+
+// Calibration of automatic encoding ===================================================================================
+// Automatic encoding picks the encoding of every file that compiles fastest for its size. Compile time is modelled per
+// encoding as a fixed time per definition plus a time per MiB of contents, and an encoding can be limited to the
+// largest size that compiled at all. Word encoding is not a candidate, because it makes the resource map non-constexpr.
+
+/// Encodings that automatic encoding picks from, in order of preference if their costs are equal.
+constexpr std::array<encoding_t, 3> automatic_encodings = {encoding_t::decimal, encoding_t::string, encoding_t::embed};
+
+constexpr std::string_view encoding_name(encoding_t encoding) noexcept {
+	switch (encoding) {
+		case encoding_t::string: return "string";
+		case encoding_t::words: return "words";
+		case encoding_t::embed: return "embed";
+		case encoding_t::incbin: return "incbin";
+		case encoding_t::object: return "object";
+		case encoding_t::automatic: return "auto";
+		default: return "decimal";
+	}
+}
+
+/// Compile time of a file definition with one encoding.
+struct encoding_cost_t {
+	double seconds = std::numeric_limits<double>::infinity();  ///< Fixed time per definition, infinite if unusable
+	double seconds_per_mib = 0;  ///< Time per MiB of contents
+	std::size_t max_size = std::numeric_limits<std::size_t>::max();  ///< Size of the largest file that compiled
+
+	double estimate(std::size_t size) const noexcept {
+		return seconds + seconds_per_mib * static_cast<double>(size) / (1024 * 1024);
+	}
+};
+
+/// Compile times of the encodings in `automatic_encodings` with one compiler.
+struct calibration_t {
+	std::array<encoding_cost_t, automatic_encodings.size()> costs;
+
+	/// Encoding that compiles fastest for a file of `size` bytes, decimal if no other encoding is usable.
+	encoding_t choose(std::size_t size) const noexcept {
+		encoding_t result = encoding_t::decimal;
+		double best = std::numeric_limits<double>::infinity();
+
+		for (std::size_t i = 0; i < costs.size(); ++i) {
+			if (size > costs[i].max_size or not (costs[i].estimate(size) < best)) continue;
+			result = automatic_encodings[i];
+			best = costs[i].estimate(size);
+		}
+
+		return result;
+	}
+};
+
+/**
+ * @brief Compile times for compilers without a calibration table, measured with GCC 12 on x86-64.
+ *
+ * Embed encoding is only picked with a calibration table, because support for `#embed` differs between compilers, and
+ * MSVC rejects string literals above 64 KiB.
+ */
+constexpr calibration_t default_calibration(std::string_view compiler_id) noexcept {
+	calibration_t result{{{
+		{.seconds = 0.000155, .seconds_per_mib = 1.19},
+		{.seconds = 0.00019, .seconds_per_mib = 0.041},
+		{},
+	}}};
+	if (compiler_id == "MSVC") result.costs[1].max_size = 64 * 1024 - 1;
+	return result;
+}
+
+/// Format one row of a calibration table.
+inline std::string format_calibration_row(
+	std::string_view compiler_id, std::string_view compiler_version, encoding_t encoding, const encoding_cost_t& cost
+) {
+	std::string result = fmt::format(
+		"{} {} {} {:.6f} {:.6f}",
+		compiler_id,
+		compiler_version,
+		encoding_name(encoding),
+		cost.seconds,
+		cost.seconds_per_mib
+	);
+	if (cost.max_size != std::numeric_limits<std::size_t>::max()) result += fmt::format(" {}", cost.max_size);
+	result += '\n';
+	return result;
+}
+
+/**
+ * @brief Load the calibration of a compiler from a calibration table.
+ *
+ * Every line of the table is `<compiler id> <compiler version> <encoding> <seconds> <seconds per MiB> [<max size>]`, as
+ * written by `syringe --calibrate`. Empty lines and lines starting with `#` are ignored. Rows of the same compiler id
+ * and version are used if there are any, otherwise the last rows of the same compiler id, otherwise the defaults.
+ */
+inline calibration_t load_calibration(std::string_view path, std::string_view compiler_id, std::string_view version) {
+	std::string text;
+	input_file file(path);
+	file.for_each_block([&](std::span<const std::uint8_t> data) { text.append(data.begin(), data.end()); });
+
+	struct row_t {
+		std::string version;
+		std::size_t encoding_index;
+		encoding_cost_t cost;
+	};
+	std::vector<row_t> rows;
+
+	std::istringstream lines(text);
+	std::string line;
+	for (std::size_t line_number = 1; std::getline(lines, line); ++line_number) {
+		if (line.empty() or line.starts_with('#') or line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+		std::istringstream fields(line);
+		std::string id;
+		row_t row;
+		std::string encoding;
+		fields >> id >> row.version >> encoding >> row.cost.seconds >> row.cost.seconds_per_mib;
+		if (not fields) {
+			throw std::runtime_error(fmt::format("invalid calibration table row at {}:{}", path, line_number));
+		}
+		if (not (fields >> row.cost.max_size)) row.cost.max_size = std::numeric_limits<std::size_t>::max();
+
+		row.encoding_index = automatic_encodings.size();
+		for (std::size_t i = 0; i < automatic_encodings.size(); ++i) {
+			if (encoding_name(automatic_encodings[i]) == encoding) row.encoding_index = i;
+		}
+		if (row.encoding_index == automatic_encodings.size()) {
+			throw std::runtime_error(fmt::format("unknown encoding \"{}\" at {}:{}", encoding, path, line_number));
+		}
+
+		if (id == compiler_id) rows.push_back(std::move(row));
+	}
+
+	// Only the rows of one version are used, so that encodings missing in a calibration run stay unusable
+	std::optional<std::string> chosen_version;
+	for (const row_t& row : rows) {
+		if (row.version == version) chosen_version = version;
+	}
+	if (not chosen_version and not rows.empty()) chosen_version = rows.back().version;
+	if (not chosen_version) return default_calibration(compiler_id);
+
+	calibration_t result;
+	for (const row_t& row : rows) {
+		if (row.version == *chosen_version) result.costs[row.encoding_index] = row.cost;
+	}
+	return result;
+}
+
+/// Calibration of the compiler of `config`, from its calibration table or the defaults.
+inline calibration_t load_calibration(const InputConfig& config) {
+	if (config.calibration_path.empty()) return default_calibration(config.compiler_id);
+	return load_calibration(config.calibration_path, config.compiler_id, config.compiler_version);
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <map>
 #include <optional>
 #include <ranges>
 #include <string>
@@ -6,6 +7,7 @@
 
 #include <filesystem>
 #include "deps/CLI11.hpp"
+#include "elf.hpp"
 #include "unicode.hpp"
 #include "util.hpp"
 
@@ -116,14 +118,46 @@ inline const char* const* argv() {
 }
 
 // Parsing CLI =========================================================================================================
+/// Representation of file contents in the generated header.
+enum class encoding_t {
+	decimal,  ///< Brace-initialized array of decimal integers
+	string,   ///< String literal with escapes, compiles faster and with less memory (not with MSVC above 64 KiB)
+	embed,    ///< `#embed` of the file where supported, with a decimal fallback
+	words,    ///< Array of 64-bit words, 8 times fewer tokens than decimal, but the resource map is not constexpr
+	incbin,   ///< `.incbin` in a separate assembly file, declared `extern` in the header
+	object,   ///< Relocatable ELF object file with the contents, declared `extern` in the header
+	automatic,  ///< Per file, the encoding that compiles fastest for its size with the compiler, see calibration.hpp
+};
+
 struct InputConfig {
 	std::unordered_map<std::string, std::string> paths;
 	std::string namespace_name;
 	std::string variable_name;
+	unsigned jobs = 0;  ///< Number of threads for processing files, 0 for hardware concurrency
+	std::size_t wrap = 0;  ///< Bytes per line of decimal file contents in fixed-width cells, 0 for one line per file
+	encoding_t encoding = encoding_t::decimal;  ///< Representation of file contents
+	std::string assembly_path;  ///< Output path of the assembly file with incbin encoding
+	std::string object_path;  ///< Output path of the object file with object encoding
+	std::uint16_t object_machine = elf::host_machine;  ///< ELF machine of the object file, see `elf::machines`
+	bool blob = false;  ///< Store the contents of all files in one array, indexed by offsets instead of pointers
+	std::size_t pool_below = 0;  ///< Store files smaller than this many bytes in one array, 0 for no pool
+	std::size_t external_above = 0;  ///< Define files larger than this in the assembly or object file, 0 for none
+	std::string calibration_path;  ///< Calibration table for automatic encoding, empty for built-in estimates
+	std::string compiler_id;  ///< Compiler that automatic encoding is calibrated for, as in CMAKE_CXX_COMPILER_ID
+	std::string compiler_version;  ///< Version of that compiler, as in CMAKE_CXX_COMPILER_VERSION
+	std::string runtime_header;  ///< Include path of a separate runtime header, empty to write the runtime into output
+	bool lite = false;  ///< Use the lite runtime, which includes fewer standard headers
+	std::string source_path;  ///< Output path of the data translation unit of a declaration-only header, if any
+	std::string source_header;  ///< Path of the header relative to the data translation unit, with forward slashes
+	std::size_t shards = 0;  ///< Number of translation units to split file definitions between, 0 for no shards
 };
 
 struct Config : InputConfig {
 	std::string output_path;
+	bool mapped_output = false;  ///< Write output through a memory mapping, encoding files in parallel
+	bool if_changed = false;  ///< Replace the output file only if its contents change
+	std::string calibrate_compiler;  ///< Write a calibration table for this compiler instead of a resource file
+	std::string runtime_output_path;  ///< Write the runtime header to this path
 };
 
 inline Config parse_cli(int argc, const char* const* argv) {
@@ -134,28 +168,181 @@ inline Config parse_cli(int argc, const char* const* argv) {
 	std::optional<std::string> relative_to;
 	std::optional<std::string> prefix;
 	std::string variable;
+	unsigned jobs = 0;
+	std::size_t wrap = 0;
+	encoding_t encoding = encoding_t::decimal;
+	std::string assembly_path;
+	std::string object_path;
+	std::uint16_t object_machine = elf::host_machine;
+	bool blob = false;
+	std::size_t pool_below = 0;
+	std::size_t external_above = 0;
+	std::string calibration_path;
+	std::string compiler_id;
+	std::string compiler_version;
+	std::string calibrate_compiler;
+	std::string runtime_header;
+	std::string runtime_output_path;
+	bool lite = false;
+	std::string source_path;
+	std::size_t shards = 0;
+	bool mapped_output = false;
+	bool if_changed = false;
 
 	// clang-format off
-	app.add_option("paths", paths, "One or more path to files for injecting")
-		->required()
+	auto* paths_option = app.add_option("paths", paths, "One or more path to files for injecting")
 		->check(ExistingFile);
-	app.add_option("-o,--output", output_path, "Path for the output file (omit to use stdout)");
+	auto* output = app.add_option("-o,--output", output_path, "Path for the output file (omit to use stdout)");
 	app.add_option("-r,--relative", relative_to, "Make paths relative to a directory")
 		->check(ExistingDirectory);
 	app.add_option("-p,--prefix", prefix, "Prefix resulting paths with a string");
 	app.add_option("--variable", variable, "Variable name for resources, e.g. \"data\" or \"my_namespace::assets\"")
 		->default_val("resources");
+	app.add_option("--wrap", wrap, "Write decimal file contents in lines of this many cells (default: no wrap)")
+		->check(CLI::NonNegativeNumber);
+	app.add_option("--encoding", encoding, "Representation of file contents (default: decimal)")
+		->transform(CLI::CheckedTransformer(
+			std::map<std::string, encoding_t>{
+				{"decimal", encoding_t::decimal},
+				{"string", encoding_t::string},
+				{"words", encoding_t::words},
+				{"embed", encoding_t::embed},
+				{"incbin", encoding_t::incbin},
+				{"object", encoding_t::object},
+				{"auto", encoding_t::automatic},
+			}
+		));
+	app.add_option("--assembly-output", assembly_path, "Path for the assembly file (required for incbin encoding)");
+	auto* object_option =
+		app.add_option("--object-output", object_path, "Path for the ELF object file (required for object encoding)");
+	app.add_option("--object-machine", object_machine, "Processor of the object file, e.g. aarch64 (default: this one)")
+		->transform(CLI::CheckedTransformer(elf::machines, CLI::ignore_case))
+		->needs(object_option);
+	app.add_flag("--blob", blob, "Store all files in one array with an index of offsets, which needs no relocations");
+	app.add_option("--pool-below", pool_below, "Store files below this many bytes in one array (default: 0, no pool)")
+		->check(CLI::NonNegativeNumber);
+	app.add_option("--external-above", external_above, "Define files above this many bytes in the .S or .o output")
+		->check(CLI::NonNegativeNumber);
+	app.add_option("--calibration", calibration_path, "Calibration table for auto encoding (default: built-in)")
+		->check(ExistingFile);
+	app.add_option("--compiler-id", compiler_id, "Compiler to pick encodings for with auto encoding, e.g. \"GNU\"");
+	app.add_option("--compiler-version", compiler_version, "Version of the compiler to pick encodings for");
+	app.add_option("--calibrate", calibrate_compiler, "Write a calibration table by compiling samples with a compiler")
+		->excludes(paths_option);
+	app.add_option("--runtime-header", runtime_header, "Include the runtime from a header, e.g. syringe/runtime.hpp");
+	app.add_option("--runtime-output", runtime_output_path, "Write the runtime header to a path");
+	auto* source_option =
+		app.add_option("--source-output", source_path, "Write file contents to a .cpp file, declarations to output")
+			->needs(output);
+	app.add_option("--shards", shards, "Split file contents of --source-output between this many more .cpp files")
+		->check(CLI::PositiveNumber)
+		->needs(source_option);
+	app.add_flag("--lite", lite, "Use a runtime that only includes <cstddef>, <cstdint>, <span> and <string_view>");
+	app.add_flag("--mapped-output", mapped_output, "Preallocate the output file and encode files into it in parallel")
+		->needs(output);
+	app.add_flag("--if-changed", if_changed, "Replace the output file atomically, and only if its contents change")
+		->needs(output);
+	app.add_option("-j,--jobs", jobs, "Number of threads for processing files (default: hardware concurrency)")
+		->check(CLI::NonNegativeNumber);
 	// clang-format on
 
 	try {
 		app.parse(argc, argv);
 		Config config;
+		config.calibrate_compiler = std::move(calibrate_compiler);
+		config.runtime_output_path = std::move(runtime_output_path);
+		if (config.calibrate_compiler.empty() and config.runtime_output_path.empty() and paths.empty()) {
+			throw CLI::RequiredError("paths");
+		}
+		config.jobs = jobs;
+		config.encoding = encoding;
+
+		// Only decimal contents are written in fixed-width cells, the other encodings are written on one line
+		config.wrap = wrap;
+		bool wrap_encoding = config.encoding == encoding_t::decimal or config.encoding == encoding_t::embed;
+		if (config.wrap != 0 and not wrap_encoding and config.encoding != encoding_t::automatic) {
+			throw CLI::ValidationError("--wrap requires decimal, embed or auto encoding");
+		}
+		config.assembly_path = std::move(assembly_path);
+		if (config.encoding == encoding_t::incbin and config.assembly_path.empty()) {
+			throw CLI::ValidationError("--encoding incbin requires --assembly-output");
+		}
+		config.object_path = std::move(object_path);
+		config.object_machine = object_machine;
+		if (config.encoding == encoding_t::object and config.object_path.empty()) {
+			throw CLI::ValidationError("--encoding object requires --object-output");
+		}
+
+		// Files stored together are encoded as one sequence of bytes, which only works with some encodings
+		bool blob_encoding = config.encoding == encoding_t::decimal or config.encoding == encoding_t::string;
+		config.blob = blob;
+		if (config.blob and not blob_encoding) {
+			throw CLI::ValidationError("--blob requires decimal or string encoding");
+		}
+		config.pool_below = pool_below;
+		if (config.pool_below != 0 and config.blob) {
+			throw CLI::ValidationError("--pool-below has no effect with --blob, which stores all files together");
+		}
+		if (config.pool_below != 0 and not blob_encoding) {
+			throw CLI::ValidationError("--pool-below requires decimal or string encoding");
+		}
+
+		// Large files are routed to whichever of the assembly or object file is written
+		config.external_above = external_above;
+		if (config.external_above != 0) {
+			if (config.encoding == encoding_t::incbin or config.encoding == encoding_t::object) {
+				throw CLI::ValidationError("--external-above has no effect with incbin or object encoding");
+			}
+			if (config.assembly_path.empty() == config.object_path.empty()) {
+				throw CLI::ValidationError("--external-above requires one of --assembly-output or --object-output");
+			}
+			if (config.blob) throw CLI::ValidationError("--external-above can't be combined with --blob");
+		}
+		config.calibration_path = std::move(calibration_path);
+		config.compiler_id = std::move(compiler_id);
+		config.compiler_version = std::move(compiler_version);
+		if (not config.calibrate_compiler.empty() and (config.compiler_id.empty() or config.compiler_version.empty())) {
+			throw CLI::ValidationError("--calibrate requires --compiler-id and --compiler-version to label the table");
+		}
+		config.runtime_header = std::move(runtime_header);
+
+		// The lite runtime has no std::array, which the definitions of the other encodings and the blob index need
+		config.lite = lite;
+		bool lite_encoding =
+			blob_encoding or config.encoding == encoding_t::incbin or config.encoding == encoding_t::object;
+		if (config.lite and not lite_encoding) {
+			throw CLI::ValidationError("--lite requires decimal, string, incbin or object encoding");
+		}
+		if (config.lite and config.blob) throw CLI::ValidationError("--lite can't be combined with --blob");
+		config.mapped_output = mapped_output;
+		config.if_changed = if_changed;
 
 		config.output_path = output_path.value_or("");
 		if (config.output_path == "-") {
 			config.output_path = "";
 		}
 
+		// The data translation unit includes the header by a path relative to itself
+		config.source_path = std::move(source_path);
+		if (not config.source_path.empty()) {
+			if (config.output_path.empty()) throw CLI::ValidationError("--source-output requires a file --output");
+			if (config.blob) throw CLI::ValidationError("--source-output can't be combined with --blob");
+
+			// Word spans are initialized dynamically, other translation units could read the map before that
+			if (config.encoding == encoding_t::words) {
+				throw CLI::ValidationError("--source-output can't be combined with --encoding words");
+			}
+
+			auto header = std::filesystem::absolute(widen(config.output_path)).lexically_normal();
+			auto source = std::filesystem::absolute(widen(config.source_path)).lexically_normal();
+			config.source_header = narrow(header.lexically_relative(source.parent_path()).native());
+			std::ranges::replace(config.source_header, '\\', '/');
+		}
+		config.shards = shards;
+		if (config.shards != 0 and config.mapped_output) {
+			throw CLI::ValidationError("--mapped-output has no effect with --shards, which are encoded in parallel");
+		}
+
 		// Compute variable and namespace name -------------------------------------------------------------------------
 		std::size_t split_pos = variable.rfind("::");
 		if (split_pos == std::string::npos) {
@@ -0,0 +1,276 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "deps/fmt.hpp"
+
+// ELF relocatable objects =============================================================================================
+// Only the parts of ELF-64 that a data-only object needs are defined here, so that objects can be written on any host.
+
+namespace elf {
+
+struct header_t {
+	std::uint8_t ident[16];
+	std::uint16_t type;
+	std::uint16_t machine;
+	std::uint32_t version;
+	std::uint64_t entry;
+	std::uint64_t phoff;
+	std::uint64_t shoff;
+	std::uint32_t flags;
+	std::uint16_t ehsize;
+	std::uint16_t phentsize;
+	std::uint16_t phnum;
+	std::uint16_t shentsize;
+	std::uint16_t shnum;
+	std::uint16_t shstrndx;
+};
+
+struct section_t {
+	std::uint32_t name;
+	std::uint32_t type;
+	std::uint64_t flags;
+	std::uint64_t addr;
+	std::uint64_t offset;
+	std::uint64_t size;
+	std::uint32_t link;
+	std::uint32_t info;
+	std::uint64_t addralign;
+	std::uint64_t entsize;
+};
+
+struct symbol_t {
+	std::uint32_t name;
+	std::uint8_t info;
+	std::uint8_t other;
+	std::uint16_t shndx;
+	std::uint64_t value;
+	std::uint64_t size;
+};
+
+static_assert(sizeof(header_t) == 64 and sizeof(section_t) == 64 and sizeof(symbol_t) == 24);
+
+constexpr std::uint16_t et_rel = 1;
+constexpr std::uint32_t sht_progbits = 1;
+constexpr std::uint32_t sht_symtab = 2;
+constexpr std::uint32_t sht_strtab = 3;
+constexpr std::uint32_t sht_group = 17;
+constexpr std::uint64_t shf_alloc = 0x2;
+constexpr std::uint64_t shf_group = 0x200;
+constexpr std::uint32_t grp_comdat = 1;
+constexpr std::uint8_t stb_global = 1;
+constexpr std::uint8_t stt_object = 1;
+constexpr std::uint16_t shn_loreserve = 0xff00;
+
+constexpr std::uint16_t em_x86_64 = 62;
+constexpr std::uint16_t em_aarch64 = 183;
+
+/// Machine that the generator is built for, the default machine of objects. 0 if objects are not supported for it.
+#if defined(__x86_64__) || defined(_M_X64)
+constexpr std::uint16_t host_machine = em_x86_64;
+#elif defined(__aarch64__) || defined(_M_ARM64)
+constexpr std::uint16_t host_machine = em_aarch64;
+#else
+constexpr std::uint16_t host_machine = 0;
+#endif
+
+/// Machines that objects can be written for, by processor names as in CMAKE_SYSTEM_PROCESSOR, in lowercase.
+inline const std::map<std::string, std::uint16_t> machines = {
+	{"x86_64", em_x86_64},
+	{"amd64", em_x86_64},
+	{"aarch64", em_aarch64},
+	{"arm64", em_aarch64},
+};
+
+/// A global symbol in its own read-only section, defined by the contents of a file.
+struct data_symbol_t {
+	std::string name;
+	std::size_t size;
+};
+
+/// Alignment of the data of every symbol, enough for any SIMD load.
+constexpr std::size_t data_alignment = 64;
+
+constexpr std::size_t align_up(std::size_t value, std::size_t alignment) noexcept {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * @brief Layout of a relocatable ELF-64 object that defines a data symbol for every file.
+ *
+ * Every symbol has its own `.rodata.<name>` section in a COMDAT group named after the symbol, so that the same file in
+ * several objects is linked once, and unused files can be removed with `--gc-sections`. The object has no relocations
+ * and no code. The layout is computed up front, so the object can be allocated at once and the data of every symbol can
+ * be copied into it independently. Everything except the data is written by `write_headers`.
+ */
+class object_layout {
+public:
+	/// Layout of an object for `machine`, which has to be little-endian like all machines in `machines`.
+	object_layout(std::span<const data_symbol_t> symbols, std::uint16_t machine) :
+		m_symbols(symbols),
+		m_machine(machine) {
+		if (machine == 0) throw std::runtime_error("object files are not supported on this architecture");
+		if (std::endian::native != std::endian::little) {
+			throw std::runtime_error("object files can only be written on little-endian hosts");
+		}
+
+		// Null, .strtab, .symtab, .note.GNU-stack, then a group and a data section per symbol
+		std::size_t section_count = 4 + 2 * symbols.size();
+		if (section_count >= shn_loreserve) {
+			throw std::runtime_error(fmt::format("too many files for an object file: {}", symbols.size()));
+		}
+
+		// One string table holds section and symbol names, a symbol name is the end of its section name
+		m_strings.push_back('\0');
+		m_strings += ".strtab";
+		m_strings.push_back('\0');
+		m_strings += ".symtab";
+		m_strings.push_back('\0');
+		m_strings += ".note.GNU-stack";
+		m_strings.push_back('\0');
+		m_strings += ".group";
+		m_strings.push_back('\0');
+
+		for (const data_symbol_t& symbol : symbols) {
+			m_name_offsets.push_back(m_strings.size());
+			m_strings += ".rodata.";
+			m_strings += symbol.name;
+			m_strings.push_back('\0');
+		}
+
+		std::size_t offset = sizeof(header_t);
+		m_strings_offset = offset;
+		offset += m_strings.size();
+
+		offset = align_up(offset, alignof(symbol_t));
+		m_symbols_offset = offset;
+		offset += (symbols.size() + 1) * sizeof(symbol_t);
+
+		m_groups_offset = offset;
+		offset += symbols.size() * 2 * sizeof(std::uint32_t);
+
+		for (const data_symbol_t& symbol : symbols) {
+			offset = align_up(offset, data_alignment);
+			m_data_offsets.push_back(offset);
+			offset += symbol.size;
+		}
+
+		offset = align_up(offset, alignof(section_t));
+		m_sections_offset = offset;
+		m_size = offset + section_count * sizeof(section_t);
+	}
+
+	/// Size of the complete object.
+	std::size_t size() const noexcept {
+		return m_size;
+	}
+
+	/// Offset of the data of symbol `i` in the object.
+	std::size_t data_offset(std::size_t i) const noexcept {
+		return m_data_offsets[i];
+	}
+
+	/// Write everything except the data of symbols into a zero-filled object of `size()` bytes.
+	void write_headers(char* out) const {
+		std::size_t section_count = 4 + 2 * m_symbols.size();
+
+		header_t header{};
+		const std::uint8_t ident[] = {
+			0x7f, 'E', 'L', 'F', 2 /* 64-bit */, 1 /* little-endian */, 1 /* version */
+		};
+		std::memcpy(header.ident, ident, sizeof(ident));
+		header.type = et_rel;
+		header.machine = m_machine;
+		header.version = 1;
+		header.shoff = m_sections_offset;
+		header.ehsize = sizeof(header_t);
+		header.shentsize = sizeof(section_t);
+		header.shnum = static_cast<std::uint16_t>(section_count);
+		header.shstrndx = 1;
+		std::memcpy(out, &header, sizeof(header));
+
+		std::memcpy(out + m_strings_offset, m_strings.data(), m_strings.size());
+
+		std::vector<section_t> sections(section_count);
+		sections[1] = {
+			.name = 1,
+			.type = sht_strtab,
+			.offset = m_strings_offset,
+			.size = m_strings.size(),
+			.addralign = 1,
+		};
+		sections[2] = {
+			.name = 9,
+			.type = sht_symtab,
+			.offset = m_symbols_offset,
+			.size = (m_symbols.size() + 1) * sizeof(symbol_t),
+			.link = 1,
+			.info = 1,  // Index of the first global symbol
+			.addralign = alignof(symbol_t),
+			.entsize = sizeof(symbol_t),
+		};
+		sections[3] = {.name = 17, .type = sht_progbits, .offset = m_groups_offset, .addralign = 1};
+
+		for (std::size_t i = 0; i < m_symbols.size(); ++i) {
+			auto group_index = static_cast<std::uint32_t>(4 + 2 * i);
+			auto data_index = static_cast<std::uint32_t>(group_index + 1);
+			auto symbol_index = static_cast<std::uint32_t>(i + 1);
+			auto name_offset = static_cast<std::uint32_t>(m_name_offsets[i]);
+
+			symbol_t symbol{
+				.name = name_offset + static_cast<std::uint32_t>(std::string_view(".rodata.").size()),
+				.info = static_cast<std::uint8_t>((stb_global << 4) | stt_object),
+				.shndx = static_cast<std::uint16_t>(data_index),
+				.size = m_symbols[i].size,
+			};
+			std::memcpy(out + m_symbols_offset + symbol_index * sizeof(symbol_t), &symbol, sizeof(symbol));
+
+			const std::uint32_t group[] = {grp_comdat, data_index};
+			std::size_t group_offset = m_groups_offset + i * sizeof(group);
+			std::memcpy(out + group_offset, group, sizeof(group));
+
+			sections[group_index] = {
+				.name = 33,
+				.type = sht_group,
+				.offset = group_offset,
+				.size = sizeof(group),
+				.link = 2,
+				.info = symbol_index,
+				.addralign = alignof(std::uint32_t),
+				.entsize = sizeof(std::uint32_t),
+			};
+			sections[data_index] = {
+				.name = name_offset,
+				.type = sht_progbits,
+				.flags = shf_alloc | shf_group,
+				.offset = m_data_offsets[i],
+				.size = m_symbols[i].size,
+				.addralign = data_alignment,
+			};
+		}
+
+		std::memcpy(out + m_sections_offset, sections.data(), sections.size() * sizeof(section_t));
+	}
+
+private:
+	std::span<const data_symbol_t> m_symbols;
+	std::uint16_t m_machine;
+	std::string m_strings;
+	std::vector<std::size_t> m_name_offsets;
+	std::vector<std::size_t> m_data_offsets;
+	std::size_t m_strings_offset = 0;
+	std::size_t m_symbols_offset = 0;
+	std::size_t m_groups_offset = 0;
+	std::size_t m_sections_offset = 0;
+	std::size_t m_size = 0;
+};
+
+}  // namespace elf
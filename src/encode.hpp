@@ -0,0 +1,648 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SYRINGE_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#define SYRINGE_X86 0
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SYRINGE_TARGET(arch) __attribute__((target(arch)))
+#else
+#define SYRINGE_TARGET(arch)
+#endif
+
+// Encoding of bytes as C++ decimal literals ===========================================================================
+// Every byte is written as ",<decimal>", so the output of an encoder always begins with a separator. Callers drop the
+// first character of the first block they encode in a file.
+
+/// Extra bytes past the end of the encoded text that encoders are allowed to overwrite.
+constexpr std::size_t encode_slack = 32;
+
+/// Maximum number of characters produced by encoding `size` bytes, including the slack encoders are allowed to use.
+constexpr std::size_t decimal_size_bound(std::size_t size) noexcept {
+	return 4 * size + encode_slack;
+}
+
+namespace detail {
+
+struct decimal_entry_t {
+	std::array<char, 4> text;
+	std::uint8_t size;
+};
+
+/// Encoding of every byte value as ",<decimal>", padded to 4 characters.
+constexpr auto decimal_table = []() {
+	std::array<decimal_entry_t, 256> result{};
+
+	for (int byte = 0; byte < 256; ++byte) {
+		auto& [text, size] = result[byte];
+		text[size++] = ',';
+		if (byte >= 100) text[size++] = static_cast<char>('0' + byte / 100);
+		if (byte >= 10) text[size++] = static_cast<char>('0' + byte / 10 % 10);
+		text[size++] = static_cast<char>('0' + byte % 10);
+	}
+
+	return result;
+}();
+
+struct decimal_shuffle_t {
+	std::array<std::uint8_t, 16> mask;
+	std::uint8_t size;
+};
+
+/**
+ * @brief Shuffle masks that compact four ",hdu" cells into their shortest form.
+ *
+ * SIMD encoders produce every byte as a fixed 4-character cell: a separator followed by hundreds, tens and unit
+ * digits. The leading zero digits of each cell are then removed with a single byte shuffle. The mask is selected by
+ * the digit count classes of the four bytes, as `c0 + 3*c1 + 9*c2 + 27*c3`.
+ */
+constexpr auto decimal_shuffle_table = []() {
+	std::array<decimal_shuffle_t, 81> result{};
+
+	for (int index = 0; index < 81; ++index) {
+		auto& [mask, size] = result[index];
+		mask.fill(0x80);
+
+		int cell_classes = index;
+		for (int cell = 0; cell < 4; ++cell) {
+			int digits = cell_classes % 3 + 1;
+			cell_classes /= 3;
+
+			mask[size++] = static_cast<std::uint8_t>(4 * cell);
+			for (int digit = 4 - digits; digit < 4; ++digit) mask[size++] = static_cast<std::uint8_t>(4 * cell + digit);
+		}
+	}
+
+	return result;
+}();
+
+}  // namespace detail
+
+/// Encode bytes with a lookup table. Writes at most `decimal_size_bound(data.size())` characters.
+inline char* encode_decimal_scalar(std::span<const std::uint8_t> data, char* out) noexcept {
+	for (std::uint8_t byte : data) {
+		const auto& entry = detail::decimal_table[byte];
+		std::memcpy(out, entry.text.data(), 4);
+		out += entry.size;
+	}
+
+	return out;
+}
+
+#if SYRINGE_X86
+namespace detail {
+
+/// Compute hundreds, tens and unit digits of 8 bytes zero-extended to 16-bit lanes. Digits are returned as characters.
+SYRINGE_TARGET("sse4.1")
+inline void decimal_digits_sse41(__m128i x, __m128i& h, __m128i& t, __m128i& u) noexcept {
+	// x / 100 == (x * 41) >> 12 and x / 10 == (x * 205) >> 11 for all values in range
+	h = _mm_mulhi_epu16(x, _mm_set1_epi16(41 << 4));
+	__m128i r = _mm_sub_epi16(x, _mm_mullo_epi16(h, _mm_set1_epi16(100)));
+	t = _mm_mulhi_epu16(r, _mm_set1_epi16(205 << 5));
+	u = _mm_sub_epi16(r, _mm_mullo_epi16(t, _mm_set1_epi16(10)));
+
+	__m128i zero = _mm_set1_epi16('0');
+	h = _mm_add_epi16(h, zero);
+	t = _mm_add_epi16(t, zero);
+	u = _mm_add_epi16(u, zero);
+}
+
+/// Compute shuffle table indices of four groups of four bytes, one 32-bit index per group.
+SYRINGE_TARGET("sse4.1")
+inline __m128i decimal_shuffle_indices_sse41(__m128i bytes) noexcept {
+	// Unsigned comparisons: x >= 10 is max(x, 10) == x
+	__m128i ge10 = _mm_cmpeq_epi8(_mm_max_epu8(bytes, _mm_set1_epi8(10)), bytes);
+	__m128i ge100 = _mm_cmpeq_epi8(_mm_max_epu8(bytes, _mm_set1_epi8(100)), bytes);
+	__m128i classes = _mm_sub_epi8(_mm_setzero_si128(), _mm_add_epi8(ge10, ge100));
+
+	__m128i pairs = _mm_maddubs_epi16(classes, _mm_set1_epi32(0x1b090301));  // c0 + 3*c1, 9*c2 + 27*c3
+	return _mm_madd_epi16(pairs, _mm_set1_epi16(1));
+}
+
+SYRINGE_TARGET("sse4.1")
+inline char* store_cells_sse41(__m128i cells, int index, char* out) noexcept {
+	const auto& shuffle = decimal_shuffle_table[index];
+	__m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffle.mask.data()));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(cells, mask));
+	return out + shuffle.size;
+}
+
+}  // namespace detail
+
+/// Encode bytes 16 at a time using SSE4.1. Writes at most `decimal_size_bound(data.size())` characters.
+SYRINGE_TARGET("sse4.1")
+inline char* encode_decimal_sse41(std::span<const std::uint8_t> data, char* out) noexcept {
+	using namespace detail;
+
+	const std::uint8_t* current = data.data();
+	const std::uint8_t* last = current + data.size() / 16 * 16;
+	const __m128i comma = _mm_set1_epi8(',');
+
+	for (; current != last; current += 16) {
+		__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current));
+
+		__m128i h_lo, t_lo, u_lo, h_hi, t_hi, u_hi;
+		decimal_digits_sse41(_mm_cvtepu8_epi16(bytes), h_lo, t_lo, u_lo);
+		decimal_digits_sse41(_mm_unpackhi_epi8(bytes, _mm_setzero_si128()), h_hi, t_hi, u_hi);
+
+		__m128i h = _mm_packus_epi16(h_lo, h_hi);
+		__m128i t = _mm_packus_epi16(t_lo, t_hi);
+		__m128i u = _mm_packus_epi16(u_lo, u_hi);
+
+		// Interleave into ",htu" cells, four bytes per register
+		__m128i ch_lo = _mm_unpacklo_epi8(comma, h);
+		__m128i ch_hi = _mm_unpackhi_epi8(comma, h);
+		__m128i tu_lo = _mm_unpacklo_epi8(t, u);
+		__m128i tu_hi = _mm_unpackhi_epi8(t, u);
+
+		__m128i indices = decimal_shuffle_indices_sse41(bytes);
+
+		out = store_cells_sse41(_mm_unpacklo_epi16(ch_lo, tu_lo), _mm_extract_epi32(indices, 0), out);
+		out = store_cells_sse41(_mm_unpackhi_epi16(ch_lo, tu_lo), _mm_extract_epi32(indices, 1), out);
+		out = store_cells_sse41(_mm_unpacklo_epi16(ch_hi, tu_hi), _mm_extract_epi32(indices, 2), out);
+		out = store_cells_sse41(_mm_unpackhi_epi16(ch_hi, tu_hi), _mm_extract_epi32(indices, 3), out);
+	}
+
+	return encode_decimal_scalar({current, data.data() + data.size()}, out);
+}
+
+namespace detail {
+
+SYRINGE_TARGET("avx2")
+inline void decimal_digits_avx2(__m256i x, __m256i& h, __m256i& t, __m256i& u) noexcept {
+	h = _mm256_mulhi_epu16(x, _mm256_set1_epi16(41 << 4));
+	__m256i r = _mm256_sub_epi16(x, _mm256_mullo_epi16(h, _mm256_set1_epi16(100)));
+	t = _mm256_mulhi_epu16(r, _mm256_set1_epi16(205 << 5));
+	u = _mm256_sub_epi16(r, _mm256_mullo_epi16(t, _mm256_set1_epi16(10)));
+
+	__m256i zero = _mm256_set1_epi16('0');
+	h = _mm256_add_epi16(h, zero);
+	t = _mm256_add_epi16(t, zero);
+	u = _mm256_add_epi16(u, zero);
+}
+
+SYRINGE_TARGET("avx2")
+inline __m256i decimal_shuffle_indices_avx2(__m256i bytes) noexcept {
+	__m256i ge10 = _mm256_cmpeq_epi8(_mm256_max_epu8(bytes, _mm256_set1_epi8(10)), bytes);
+	__m256i ge100 = _mm256_cmpeq_epi8(_mm256_max_epu8(bytes, _mm256_set1_epi8(100)), bytes);
+	__m256i classes = _mm256_sub_epi8(_mm256_setzero_si256(), _mm256_add_epi8(ge10, ge100));
+
+	__m256i pairs = _mm256_maddubs_epi16(classes, _mm256_set1_epi32(0x1b090301));
+	return _mm256_madd_epi16(pairs, _mm256_set1_epi16(1));
+}
+
+/// Compact two groups of four cells held in the low and high lanes of a register.
+SYRINGE_TARGET("avx2")
+inline char* store_cells_avx2(__m256i cells, int index_lo, int index_hi, char* out) noexcept {
+	const auto& shuffle_lo = decimal_shuffle_table[index_lo];
+	const auto& shuffle_hi = decimal_shuffle_table[index_hi];
+	__m256i mask = _mm256_loadu2_m128i(
+		reinterpret_cast<const __m128i*>(shuffle_hi.mask.data()),
+		reinterpret_cast<const __m128i*>(shuffle_lo.mask.data())
+	);
+	__m256i compacted = _mm256_shuffle_epi8(cells, mask);
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_castsi256_si128(compacted));
+	out += shuffle_lo.size;
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_extracti128_si256(compacted, 1));
+	return out + shuffle_hi.size;
+}
+
+}  // namespace detail
+
+/// Encode bytes 32 at a time using AVX2. Writes at most `decimal_size_bound(data.size())` characters.
+SYRINGE_TARGET("avx2")
+inline char* encode_decimal_avx2(std::span<const std::uint8_t> data, char* out) noexcept {
+	using namespace detail;
+
+	const std::uint8_t* current = data.data();
+	const std::uint8_t* last = current + data.size() / 32 * 32;
+	const __m256i comma = _mm256_set1_epi8(',');
+
+	for (; current != last; current += 32) {
+		__m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(current));
+
+		// Unpacking works within 128-bit lanes: the low lane holds bytes 0-15 and the high lane holds bytes 16-31
+		__m256i h_lo, t_lo, u_lo, h_hi, t_hi, u_hi;
+		decimal_digits_avx2(_mm256_unpacklo_epi8(bytes, _mm256_setzero_si256()), h_lo, t_lo, u_lo);
+		decimal_digits_avx2(_mm256_unpackhi_epi8(bytes, _mm256_setzero_si256()), h_hi, t_hi, u_hi);
+
+		__m256i h = _mm256_packus_epi16(h_lo, h_hi);
+		__m256i t = _mm256_packus_epi16(t_lo, t_hi);
+		__m256i u = _mm256_packus_epi16(u_lo, u_hi);
+
+		__m256i ch_lo = _mm256_unpacklo_epi8(comma, h);
+		__m256i ch_hi = _mm256_unpackhi_epi8(comma, h);
+		__m256i tu_lo = _mm256_unpacklo_epi8(t, u);
+		__m256i tu_hi = _mm256_unpackhi_epi8(t, u);
+
+		__m256i cells0 = _mm256_unpacklo_epi16(ch_lo, tu_lo);  // bytes 0-3 and 16-19
+		__m256i cells1 = _mm256_unpackhi_epi16(ch_lo, tu_lo);  // bytes 4-7 and 20-23
+		__m256i cells2 = _mm256_unpacklo_epi16(ch_hi, tu_hi);  // bytes 8-11 and 24-27
+		__m256i cells3 = _mm256_unpackhi_epi16(ch_hi, tu_hi);  // bytes 12-15 and 28-31
+
+		alignas(32) std::array<int, 8> indices;
+		_mm256_store_si256(reinterpret_cast<__m256i*>(indices.data()), decimal_shuffle_indices_avx2(bytes));
+
+		out = store_cells_avx2(_mm256_permute2x128_si256(cells0, cells1, 0x20), indices[0], indices[1], out);
+		out = store_cells_avx2(_mm256_permute2x128_si256(cells2, cells3, 0x20), indices[2], indices[3], out);
+		out = store_cells_avx2(_mm256_permute2x128_si256(cells0, cells1, 0x31), indices[4], indices[5], out);
+		out = store_cells_avx2(_mm256_permute2x128_si256(cells2, cells3, 0x31), indices[6], indices[7], out);
+	}
+
+	return encode_decimal_sse41({current, data.data() + data.size()}, out);
+}
+#endif  // SYRINGE_X86
+
+// Runtime dispatch ====================================================================================================
+using decimal_encoder_t = char* (*)(std::span<const std::uint8_t>, char*) noexcept;
+
+enum class cpu_feature { sse41, avx2 };
+
+inline bool cpu_supports(cpu_feature feature) noexcept {
+#if SYRINGE_X86 && (defined(__GNUC__) || defined(__clang__))
+	switch (feature) {
+		case cpu_feature::sse41:
+			return __builtin_cpu_supports("sse4.1");
+		case cpu_feature::avx2:
+			return __builtin_cpu_supports("avx2");
+	}
+	return false;
+#elif SYRINGE_X86 && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int max_leaf = info[0];
+
+	__cpuid(info, 1);
+	bool sse41 = info[2] & (1 << 19);
+	bool os_avx = (info[2] & (1 << 27)) and (info[2] & (1 << 28)) and (_xgetbv(0) & 6) == 6;
+
+	switch (feature) {
+		case cpu_feature::sse41:
+			return sse41;
+		case cpu_feature::avx2:
+			if (max_leaf < 7 or not os_avx) return false;
+			__cpuidex(info, 7, 0);
+			return info[1] & (1 << 5);
+	}
+	return false;
+#else
+	(void)feature;
+	return false;
+#endif
+}
+
+/// Select the fastest decimal encoder supported by the current CPU.
+inline decimal_encoder_t select_decimal_encoder() noexcept {
+#if SYRINGE_X86
+	if (cpu_supports(cpu_feature::avx2)) return encode_decimal_avx2;
+	if (cpu_supports(cpu_feature::sse41)) return encode_decimal_sse41;
+#endif
+	return encode_decimal_scalar;
+}
+
+/**
+ * @brief Encode bytes as comma-prefixed decimal integers, such as ",97,98,99".
+ *
+ * `out` must have room for at least `decimal_size_bound(data.size())` characters.
+ *
+ * @return Pointer past the last character written.
+ */
+inline char* encode_decimal(std::span<const std::uint8_t> data, char* out) noexcept {
+	static const decimal_encoder_t encoder = select_decimal_encoder();
+	return encoder(data, out);
+}
+
+/// Append encoded bytes to a string.
+inline void encode_decimal(std::span<const std::uint8_t> data, std::string& out) {
+	std::size_t old_size = out.size();
+	out.resize(old_size + decimal_size_bound(data.size()));
+
+	char* end = encode_decimal(data, out.data() + old_size);
+	out.resize(end - out.data());
+}
+
+/// Number of characters written by `encode_decimal` for `data`, including the separator before every byte.
+inline std::size_t decimal_size(std::span<const std::uint8_t> data) noexcept {
+	std::size_t result = 0;
+	for (std::uint8_t byte : data) result += detail::decimal_table[byte].size;
+
+	return result;
+}
+
+/**
+ * @brief Encode bytes as decimal integers separated by comma, such as "97,98,99".
+ *
+ * Unlike `encode_decimal`, this function writes exactly `decimal_size(data) - 1` characters (none for empty data) and
+ * nothing past them, so it can be used to fill a preallocated region of a larger output.
+ *
+ * @return Pointer past the last character written.
+ */
+inline char* encode_decimal_list(std::span<const std::uint8_t> data, char* out) noexcept {
+	if (data.empty()) return out;
+
+	const auto& first = detail::decimal_table[data[0]];
+	out = std::copy(first.text.begin() + 1, first.text.begin() + first.size, out);
+	data = data.subspan(1);
+
+	// Every byte takes at least 2 characters, so the slack written by the bulk encoding is overwritten by the tail
+	constexpr std::size_t tail_size = encode_slack / 2;
+	std::size_t bulk_size = data.size() > tail_size ? data.size() - tail_size : 0;
+	out = encode_decimal(data.first(bulk_size), out);
+
+	std::array<char, decimal_size_bound(tail_size)> buffer;
+	char* buffer_end = encode_decimal(data.subspan(bulk_size), buffer.data());
+	return std::copy(buffer.data(), buffer_end, out);
+}
+
+// Wrapped encoding ====================================================================================================
+// Every byte is written as a fixed-width cell "<decimal>," right-aligned to 3 digits, such as " 97,". Lines hold the
+// same number of cells and begin with "\n\t", so all lines of a file have the same length and the encoded size only
+// depends on the number of bytes.
+
+namespace detail {
+
+/// Encoding of every byte value as a fixed-width cell.
+constexpr auto fixed_cell_table = []() {
+	std::array<std::array<char, 4>, 256> result{};
+
+	for (int byte = 0; byte < 256; ++byte) {
+		auto& text = result[byte];
+		text[0] = byte >= 100 ? static_cast<char>('0' + byte / 100) : ' ';
+		text[1] = byte >= 10 ? static_cast<char>('0' + byte / 10 % 10) : ' ';
+		text[2] = static_cast<char>('0' + byte % 10);
+		text[3] = ',';
+	}
+
+	return result;
+}();
+
+}  // namespace detail
+
+/// Number of characters produced by `encode_decimal_wrapped` for `size` bytes with `wrap` bytes per line.
+constexpr std::size_t wrapped_size(std::size_t size, std::size_t wrap) noexcept {
+	return 4 * size + 2 * ((size + wrap - 1) / wrap);
+}
+
+/**
+ * @brief Encode bytes as fixed-width decimal cells, `wrap` cells per line.
+ *
+ * Data can be encoded in consecutive blocks: `offset` is the number of bytes of the same file encoded before `data`,
+ * and determines where lines are broken. Exactly `wrapped_size(offset + data.size()) - wrapped_size(offset)` characters
+ * are written.
+ *
+ * @return Pointer past the last character written.
+ */
+inline char* encode_decimal_wrapped(
+	std::span<const std::uint8_t> data, std::size_t wrap, std::size_t offset, char* out
+) noexcept {
+	std::size_t column = offset % wrap;
+
+	for (std::uint8_t byte : data) {
+		if (column == 0) {
+			*out++ = '\n';
+			*out++ = '\t';
+		}
+		std::memcpy(out, detail::fixed_cell_table[byte].data(), 4);
+		out += 4;
+
+		if (++column == wrap) column = 0;
+	}
+
+	return out;
+}
+
+/// Encode bytes as fixed-width decimal cells and append them to a string, see `encode_decimal_wrapped`.
+inline void encode_decimal_wrapped(
+	std::span<const std::uint8_t> data, std::size_t wrap, std::size_t offset, std::string& out
+) {
+	std::size_t size = wrapped_size(offset + data.size(), wrap) - wrapped_size(offset, wrap);
+	std::size_t old_size = out.size();
+
+	out.resize(old_size + size);
+	encode_decimal_wrapped(data, wrap, offset, out.data() + old_size);
+}
+
+// String encoding =====================================================================================================
+// Bytes are written as the contents of ordinary string literals, one chunk of `string_chunk_size` bytes per line, such
+// as "\n\t\"abc\\0\\377\"". Printable characters are written as is, other bytes with the shortest escape sequence. An
+// octal escape is padded to 3 digits only if it is followed by an octal digit, and the second of two question marks is
+// escaped so that compilers do not warn about trigraphs.
+
+/// Number of bytes per string literal chunk. Divides the block size of readers, so chunks never span two blocks.
+constexpr std::size_t string_chunk_size = 64;
+
+namespace detail {
+
+struct string_escape_t {
+	std::array<char, 4> text;    ///< Escape if not followed by an octal digit
+	std::array<char, 4> padded;  ///< Escape if followed by an octal digit
+	std::uint8_t size;
+	std::uint8_t padded_size;
+};
+
+/// Shortest escape sequence of every byte value inside a string literal.
+constexpr auto string_escape_table = []() {
+	std::array<string_escape_t, 256> result{};
+
+	for (int byte = 0; byte < 256; ++byte) {
+		auto& [text, padded, size, padded_size] = result[byte];
+
+		auto simple_escape = [&](char c) {
+			text = padded = {'\\', c};
+			size = padded_size = 2;
+		};
+
+		switch (byte) {
+			case '"': simple_escape('"'); break;
+			case '\\': simple_escape('\\'); break;
+			case '\a': simple_escape('a'); break;
+			case '\b': simple_escape('b'); break;
+			case '\f': simple_escape('f'); break;
+			case '\n': simple_escape('n'); break;
+			case '\r': simple_escape('r'); break;
+			case '\t': simple_escape('t'); break;
+			case '\v': simple_escape('v'); break;
+			default:
+				if (byte >= 0x20 and byte < 0x7f) {
+					text = padded = {static_cast<char>(byte)};
+					size = padded_size = 1;
+				} else {
+					padded = {
+						'\\',
+						static_cast<char>('0' + byte / 64),
+						static_cast<char>('0' + byte / 8 % 8),
+						static_cast<char>('0' + byte % 8),
+					};
+					padded_size = 4;
+
+					size = static_cast<std::uint8_t>(byte >= 64 ? 4 : byte >= 8 ? 3 : 2);
+					text[0] = '\\';
+					for (int i = 1; i < size; ++i) text[i] = padded[4 - size + i];
+				}
+		}
+	}
+
+	return result;
+}();
+
+constexpr bool is_octal_digit(std::uint8_t byte) noexcept {
+	return byte >= '0' and byte <= '7';
+}
+
+/**
+ * @brief Call `escape(text, size)` with the escape sequence of every byte of `data`.
+ *
+ * Bytes are split into chunks that begin at multiples of `string_chunk_size` in the file, `begin_chunk()` and
+ * `end_chunk()` are called around each of them.
+ */
+template<typename Escape, typename BeginChunk, typename EndChunk>
+void for_each_string_escape(
+	std::span<const std::uint8_t> data,
+	std::size_t offset,
+	Escape&& escape,
+	BeginChunk&& begin_chunk,
+	EndChunk&& end_chunk
+) {
+	std::size_t i = 0;
+	while (i < data.size()) {
+		std::size_t chunk_begin = i;
+		std::size_t chunk_end = std::min(data.size(), i + string_chunk_size - (offset + i) % string_chunk_size);
+		begin_chunk();
+
+		for (; i < chunk_end; ++i) {
+			if (data[i] == '?' and i > chunk_begin and data[i - 1] == '?') {
+				escape("\\?", 2);
+				continue;
+			}
+
+			// The end of a chunk is followed by a quote. The end of data within a chunk is followed by an unknown byte.
+			const string_escape_t& entry = string_escape_table[data[i]];
+			bool data_ends_in_chunk = chunk_end == data.size() and (offset + chunk_end) % string_chunk_size != 0;
+			bool padded = i + 1 < chunk_end ? is_octal_digit(data[i + 1]) : data_ends_in_chunk;
+
+			if (padded) {
+				escape(entry.padded.data(), entry.padded_size);
+			} else {
+				escape(entry.text.data(), entry.size);
+			}
+		}
+
+		end_chunk();
+	}
+}
+
+}  // namespace detail
+
+/**
+ * @brief Number of characters produced by `encode_string` for `data`.
+ *
+ * @param offset number of bytes of the same file encoded before `data`
+ */
+inline std::size_t string_size(std::span<const std::uint8_t> data, std::size_t offset) noexcept {
+	std::size_t result = 0;
+	detail::for_each_string_escape(
+		data,
+		offset,
+		[&](const char*, std::size_t size) { result += size; },
+		[&]() { result += 3; },  // "\n\t\""
+		[&]() { result += 1; }   // "\""
+	);
+
+	return result;
+}
+
+/**
+ * @brief Encode bytes as string literal chunks, one per line.
+ *
+ * Data can be encoded in consecutive blocks: `offset` is the number of bytes of the same file encoded before `data`,
+ * and determines where chunks are broken. Exactly `string_size(data, offset)` characters are written.
+ *
+ * @return Pointer past the last character written.
+ */
+inline char* encode_string(std::span<const std::uint8_t> data, std::size_t offset, char* out) noexcept {
+	detail::for_each_string_escape(
+		data,
+		offset,
+		[&](const char* text, std::size_t size) { out = std::copy_n(text, size, out); },
+		[&]() { out = std::copy_n("\n\t\"", 3, out); },
+		[&]() { *out++ = '"'; }
+	);
+
+	return out;
+}
+
+/// Encode bytes as string literal chunks and append them to a string, see `encode_string`.
+inline void encode_string(std::span<const std::uint8_t> data, std::size_t offset, std::string& out) {
+	std::size_t old_size = out.size();
+	out.resize(old_size + string_size(data, offset));
+	encode_string(data, offset, out.data() + old_size);
+}
+
+// Word encoding =======================================================================================================
+// Bytes are packed into little-endian 64-bit words, written as fixed-width hexadecimal literals separated by commas,
+// such as "0x0000000000636261". The last word is padded with zero bytes. A word is one token instead of eight.
+
+/// Number of characters of one word literal.
+constexpr std::size_t word_literal_size = 18;
+
+/// Number of characters produced by `encode_words` for `size` bytes.
+constexpr std::size_t words_size(std::size_t size) noexcept {
+	return size == 0 ? 0 : (size + 7) / 8 * (word_literal_size + 1) - 1;
+}
+
+namespace detail {
+
+/// Two hexadecimal digits of every byte value.
+constexpr auto hex_table = []() {
+	std::array<std::array<char, 2>, 256> result{};
+	constexpr std::string_view digits = "0123456789abcdef";
+	for (int byte = 0; byte < 256; ++byte) result[byte] = {digits[byte / 16], digits[byte % 16]};
+	return result;
+}();
+
+/// Write up to 8 bytes as one word literal, most significant byte first.
+inline char* encode_word(std::span<const std::uint8_t> bytes, char* out) noexcept {
+	*out++ = '0';
+	*out++ = 'x';
+	for (std::size_t i = 8; i-- > 0;) {
+		const auto& hex = i < bytes.size() ? hex_table[bytes[i]] : hex_table[0];
+		*out++ = hex[0];
+		*out++ = hex[1];
+	}
+
+	return out;
+}
+
+}  // namespace detail
+
+/**
+ * @brief Encode bytes as comma-separated word literals.
+ *
+ * Exactly `words_size(data.size())` characters are written. Data that is encoded in consecutive blocks must be split
+ * at multiples of 8 bytes.
+ *
+ * @return Pointer past the last character written.
+ */
+inline char* encode_words(std::span<const std::uint8_t> data, char* out) noexcept {
+	for (std::size_t i = 0; i < data.size(); i += 8) {
+		if (i != 0) *out++ = ',';
+		out = detail::encode_word(data.subspan(i, std::min<std::size_t>(8, data.size() - i)), out);
+	}
+
+	return out;
+}
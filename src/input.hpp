@@ -0,0 +1,208 @@
+#pragma once
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "deps/fmt.hpp"
+#include "unicode.hpp"
+
+/**
+ * @brief Read-only access to the contents of an input file.
+ *
+ * Regular files are memory-mapped and their contents are available as a single span, without copying through a read
+ * buffer. Pipes, empty files and other files that cannot be mapped are read sequentially with large reads.
+ */
+class input_file {
+public:
+	/// Size of blocks passed to callbacks of `for_each_block`.
+	static constexpr std::size_t block_size = 1024 * 1024;
+
+	explicit input_file(std::string_view path) : m_path(path) {
+#ifdef _WIN32
+		m_handle = CreateFileW(
+			widen(path).c_str(),
+			GENERIC_READ,
+			FILE_SHARE_READ,
+			nullptr,
+			OPEN_EXISTING,
+			FILE_FLAG_SEQUENTIAL_SCAN,
+			nullptr
+		);
+		if (m_handle == INVALID_HANDLE_VALUE) throw_open_error();
+
+		// Files of size 0 can't be mapped, and are read like special files
+		LARGE_INTEGER size;
+		if (GetFileType(m_handle) != FILE_TYPE_DISK or not GetFileSizeEx(m_handle, &size)) return;
+		if (size.QuadPart == 0) return;
+
+		m_mapping = CreateFileMappingW(m_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_mapping == nullptr) return;
+
+		void* view = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+		if (view == nullptr) return;
+
+		m_data = {static_cast<const std::uint8_t*>(view), static_cast<std::size_t>(size.QuadPart)};
+		m_mapped = true;
+
+		// The view keeps the mapping alive, handles are not needed anymore
+		CloseHandle(m_mapping);
+		CloseHandle(m_handle);
+		m_mapping = nullptr;
+		m_handle = INVALID_HANDLE_VALUE;
+#else
+		m_fd = ::open(std::string(path).c_str(), O_RDONLY | O_CLOEXEC);
+		if (m_fd < 0) throw_open_error();
+
+		// Pseudo-files, such as the ones in /proc, report size 0 but have contents, which only reading returns
+		struct stat st;
+		if (::fstat(m_fd, &st) != 0 or not S_ISREG(st.st_mode)) return;
+		if (st.st_size == 0) return;
+
+		void* view = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, m_fd, 0);
+		if (view == MAP_FAILED) return;
+
+		::posix_madvise(view, static_cast<std::size_t>(st.st_size), POSIX_MADV_SEQUENTIAL);
+		m_data = {static_cast<const std::uint8_t*>(view), static_cast<std::size_t>(st.st_size)};
+		m_mapped = true;
+
+		// The mapping stays valid after the descriptor is closed
+		::close(m_fd);
+		m_fd = -1;
+#endif
+	}
+
+	input_file(input_file&& other) noexcept {
+		*this = std::move(other);
+	}
+
+	input_file& operator=(input_file&& other) noexcept {
+		if (this != &other) {
+			close();
+			m_path = std::move(other.m_path);
+			m_data = std::exchange(other.m_data, {});
+			m_mapped = std::exchange(other.m_mapped, false);
+#ifdef _WIN32
+			m_handle = std::exchange(other.m_handle, INVALID_HANDLE_VALUE);
+			m_mapping = std::exchange(other.m_mapping, nullptr);
+#else
+			m_fd = std::exchange(other.m_fd, -1);
+#endif
+		}
+		return *this;
+	}
+
+	~input_file() {
+		close();
+	}
+
+	/// True if the whole contents of the file are available through `data()`.
+	bool mapped() const noexcept {
+		return m_mapped;
+	}
+
+	/// Contents of a mapped file.
+	std::span<const std::uint8_t> data() const noexcept {
+		return m_data;
+	}
+
+	/**
+	 * @brief Call `callback` with consecutive blocks of the file's contents.
+	 *
+	 * Mapped files are split into blocks of `block_size` without copying, and can be traversed any number of times.
+	 * Other files are read into a buffer of `block_size` and can only be traversed once.
+	 */
+	template<typename F>
+	void for_each_block(F&& callback) {
+		if (m_mapped) {
+			for (std::size_t offset = 0; offset < m_data.size(); offset += block_size) {
+				callback(m_data.subspan(offset, std::min(block_size, m_data.size() - offset)));
+			}
+			return;
+		}
+
+		std::vector<std::uint8_t> buffer(block_size);
+		while (true) {
+			std::size_t count = read(buffer.data(), buffer.size());
+			if (count == 0) break;
+			callback(std::span<const std::uint8_t>(buffer.data(), count));
+		}
+	}
+
+private:
+	[[noreturn]] void throw_open_error() const {
+		throw std::runtime_error(fmt::format("could not open file: {}", m_path));
+	}
+
+	[[noreturn]] void throw_read_error() const {
+		throw std::runtime_error(fmt::format("could not read file: {}", m_path));
+	}
+
+	/// Read up to `size` bytes from the current position, retrying interrupted and partial reads. Returns 0 at EOF.
+	std::size_t read(std::uint8_t* buffer, std::size_t size) {
+		std::size_t total = 0;
+
+		while (total < size) {
+#ifdef _WIN32
+			DWORD count = 0;
+			DWORD request = static_cast<DWORD>(std::min<std::size_t>(size - total, 1u << 30));
+			if (not ReadFile(m_handle, buffer + total, request, &count, nullptr)) {
+				if (GetLastError() == ERROR_BROKEN_PIPE) break;  // Write end of a pipe was closed
+				throw_read_error();
+			}
+#else
+			ssize_t count = ::read(m_fd, buffer + total, size - total);
+			if (count < 0) {
+				if (errno == EINTR) continue;
+				throw_read_error();
+			}
+#endif
+			if (count == 0) break;
+			total += static_cast<std::size_t>(count);
+		}
+
+		return total;
+	}
+
+	void close() noexcept {
+#ifdef _WIN32
+		if (not m_data.empty()) UnmapViewOfFile(m_data.data());
+		if (m_mapping != nullptr) CloseHandle(m_mapping);
+		if (m_handle != INVALID_HANDLE_VALUE) CloseHandle(m_handle);
+		m_mapping = nullptr;
+		m_handle = INVALID_HANDLE_VALUE;
+#else
+		if (not m_data.empty()) ::munmap(const_cast<std::uint8_t*>(m_data.data()), m_data.size());
+		if (m_fd >= 0) ::close(m_fd);
+		m_fd = -1;
+#endif
+		m_data = {};
+		m_mapped = false;
+	}
+
+	std::string m_path;
+	std::span<const std::uint8_t> m_data;
+	bool m_mapped = false;
+
+#ifdef _WIN32
+	HANDLE m_handle = INVALID_HANDLE_VALUE;
+	HANDLE m_mapping = nullptr;
+#else
+	int m_fd = -1;
+#endif
+};
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "deps/fmt.hpp"
+#include "unicode.hpp"
+
+/**
+ * @brief Output file of a known size, created and mapped into memory for writing.
+ *
+ * The file is truncated and its space is allocated up front. Disjoint parts of `data()` may be written from different
+ * threads. Contents are written back when the object is destroyed.
+ */
+class output_mapping {
+public:
+	output_mapping(std::string_view path, std::size_t size) : m_path(path) {
+#ifdef _WIN32
+		m_handle = CreateFileW(
+			widen(path).c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr
+		);
+		if (m_handle == INVALID_HANDLE_VALUE) throw_error("could not create output file");
+
+		LARGE_INTEGER large_size;
+		large_size.QuadPart = static_cast<LONGLONG>(size);
+		m_mapping = CreateFileMappingW(
+			m_handle, nullptr, PAGE_READWRITE, large_size.HighPart, large_size.LowPart, nullptr
+		);
+		if (m_mapping == nullptr) throw_error("could not allocate output file");
+
+		void* view = MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, size);
+		if (view == nullptr) throw_error("could not map output file");
+#else
+		m_fd = ::open(std::string(path).c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+		if (m_fd < 0) throw_error("could not create output file");
+
+		// Reserve blocks up front so that writing through the mapping can not fail with SIGBUS on a full disk
+		int error = ::posix_fallocate(m_fd, 0, static_cast<off_t>(size));
+		if (error != 0 and ::ftruncate(m_fd, static_cast<off_t>(size)) != 0) {
+			throw_error("could not allocate output file");
+		}
+
+		void* view = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+		if (view == MAP_FAILED) throw_error("could not map output file");
+#endif
+		m_data = {static_cast<char*>(view), size};
+	}
+
+	output_mapping(const output_mapping&) = delete;
+	output_mapping& operator=(const output_mapping&) = delete;
+
+	~output_mapping() {
+#ifdef _WIN32
+		if (not m_data.empty()) UnmapViewOfFile(m_data.data());
+		if (m_mapping != nullptr) CloseHandle(m_mapping);
+		if (m_handle != INVALID_HANDLE_VALUE) CloseHandle(m_handle);
+#else
+		if (not m_data.empty()) ::munmap(m_data.data(), m_data.size());
+		if (m_fd >= 0) ::close(m_fd);
+#endif
+	}
+
+	std::span<char> data() const noexcept {
+		return m_data;
+	}
+
+private:
+	/// Throw an error, releasing everything acquired so far (the destructor does not run for a throwing constructor).
+	[[noreturn]] void throw_error(std::string_view message) {
+#ifdef _WIN32
+		if (m_mapping != nullptr) CloseHandle(m_mapping);
+		if (m_handle != INVALID_HANDLE_VALUE) CloseHandle(m_handle);
+#else
+		if (m_fd >= 0) ::close(m_fd);
+#endif
+		throw std::runtime_error(fmt::format("{}: {}", message, m_path));
+	}
+
+	std::string m_path;
+	std::span<char> m_data;
+
+#ifdef _WIN32
+	HANDLE m_handle = INVALID_HANDLE_VALUE;
+	HANDLE m_mapping = nullptr;
+#else
+	int m_fd = -1;
+#endif
+};
@@ -0,0 +1,118 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <variant>
+#include <vector>
+
+/// Number of worker threads to use when the user did not specify one.
+inline unsigned default_jobs() noexcept {
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * @brief Compute `produce(i)` for every i in [0, count) on a pool of threads and call `consume(i, result)` in order.
+ *
+ * `consume` is always called on the calling thread, in the order of indices, so the result does not depend on thread
+ * scheduling. At most `2 * jobs` results are held at once, which bounds memory use when results are large. An exception
+ * thrown by `produce` is rethrown on the calling thread when its result is consumed.
+ */
+template<typename T, typename Produce, typename Consume>
+void ordered_parallel_for(std::size_t count, unsigned jobs, Produce&& produce, Consume&& consume) {
+	if (jobs <= 1 or count <= 1) {
+		for (std::size_t i = 0; i < count; ++i) consume(i, produce(i));
+		return;
+	}
+
+	const std::size_t window = 2 * static_cast<std::size_t>(jobs);
+	std::vector<std::optional<std::variant<T, std::exception_ptr>>> slots(count);
+
+	std::mutex mutex;
+	std::condition_variable produced;
+	std::condition_variable consumed;
+	std::size_t next = 0;
+	std::size_t consumed_count = 0;
+	bool stop = false;
+
+	auto worker = [&]() {
+		while (true) {
+			std::size_t i;
+			{
+				std::unique_lock lock(mutex);
+				consumed.wait(lock, [&]() { return stop or next >= count or next < consumed_count + window; });
+				if (stop or next >= count) return;
+				i = next++;
+			}
+
+			std::variant<T, std::exception_ptr> result;
+			try {
+				result.template emplace<0>(produce(i));
+			} catch (...) {
+				result.template emplace<1>(std::current_exception());
+			}
+
+			{
+				std::lock_guard lock(mutex);
+				slots[i] = std::move(result);
+			}
+			produced.notify_all();
+		}
+	};
+
+	std::vector<std::jthread> threads;
+	auto stop_threads = [&]() {
+		{
+			std::lock_guard lock(mutex);
+			stop = true;
+		}
+		consumed.notify_all();
+		threads.clear();
+	};
+
+	try {
+		threads.reserve(std::min<std::size_t>(jobs, count));
+		for (std::size_t i = 0; i < std::min<std::size_t>(jobs, count); ++i) threads.emplace_back(worker);
+
+		for (std::size_t i = 0; i < count; ++i) {
+			std::variant<T, std::exception_ptr> result;
+			{
+				std::unique_lock lock(mutex);
+				produced.wait(lock, [&]() { return slots[i].has_value(); });
+				result = std::move(*slots[i]);
+				slots[i].reset();
+			}
+
+			if (result.index() == 1) std::rethrow_exception(std::get<1>(result));
+			consume(i, std::move(std::get<0>(result)));
+
+			{
+				std::lock_guard lock(mutex);
+				++consumed_count;
+			}
+			consumed.notify_all();
+		}
+	} catch (...) {
+		stop_threads();
+		throw;
+	}
+
+	stop_threads();
+}
+
+/// Call `function(i)` for every i in [0, count) on a pool of threads. Exceptions are rethrown on the calling thread.
+template<typename F>
+void parallel_for(std::size_t count, unsigned jobs, F&& function) {
+	ordered_parallel_for<bool>(
+		count,
+		jobs,
+		[&](std::size_t i) {
+			function(i);
+			return true;
+		},
+		[](std::size_t, bool) {}
+	);
+}
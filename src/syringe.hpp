@@ -1,128 +1,1479 @@
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <filesystem>
-#include <fstream>
-#include <iostream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <random>
 #include <ranges>
 #include <span>
-#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <system_error>
+#include <tuple>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "deps/fmt.hpp"
 #include "deps/mincemeat.hpp"
 
+#include "calibration.hpp"
 #include "cli.hpp"
+#include "elf.hpp"
+#include "encode.hpp"
+#include "input.hpp"
+#include "output.hpp"
+#include "parallel.hpp"
 #include "templates.hpp"
+#include "uring.hpp"
+#include "writer.hpp"
 
-std::string file_hash(std::string_view path) {
+/// Files larger than this are not encoded in memory, but straight from their mapping into the output.
+constexpr std::uintmax_t buffered_file_limit = 16 * 1024 * 1024;
+
+/// Files of at least this many zero bytes are defined as zero-initialized storage instead of encoded contents.
+constexpr std::size_t zero_file_min_size = 64;
+
+/// Whether all bytes of `data` are zero.
+inline bool all_zero(std::span<const std::uint8_t> data) noexcept {
+	return std::ranges::all_of(data, [](std::uint8_t byte) { return byte == 0; });
+}
+
+/// Absolute path of an input file with forward slashes, for referring to it from generated files.
+std::string absolute_path(std::string_view path) {
+	std::string result = narrow(std::filesystem::absolute(widen(path)).native());
+	std::ranges::replace(result, '\\', '/');
+	return result;
+}
+
+/// Encoding of files defined outside of the header: incbin or object encoding, or the one that `external_above` uses.
+inline encoding_t external_encoding(const InputConfig& config) noexcept {
+	if (config.encoding == encoding_t::incbin or config.encoding == encoding_t::object) return config.encoding;
+	return config.object_path.empty() ? encoding_t::incbin : encoding_t::object;
+}
+
+/**
+ * @brief Encoder of file contents into the body of a file definition, fed block by block.
+ *
+ * The encoder keeps track of the position in the file, so blocks must be passed in order, and one encoder is used for
+ * one file. The text around the encoded contents depends on the encoding too, and is produced by the same object.
+ */
+class literal_encoder {
+public:
+	literal_encoder() = default;
+	explicit literal_encoder(const InputConfig& config) :
+		m_encoding(config.encoding),
+		m_wrap(config.wrap),
+		m_blob(config.blob),
+		m_lite(config.lite),
+		m_external_above(config.external_above),
+		m_external_encoding(external_encoding(config)),
+		m_calibration(config.encoding == encoding_t::automatic ? load_calibration(config) : calibration_t{}) {}
+
+	/**
+	 * @brief Encoder for a file of `size` bytes.
+	 *
+	 * Files above `external_above` are defined outside of the header, and automatic encoding picks the encoding that
+	 * compiles fastest for the size. The other encodings are used for every file.
+	 */
+	literal_encoder routed(std::size_t size) const noexcept {
+		if (m_external_above != 0 and size > m_external_above) return with_encoding(m_external_encoding);
+		if (m_encoding == encoding_t::automatic) return with_encoding(m_calibration.choose(size));
+		return *this;
+	}
+
+	/// Encoder for a file that `routed` has picked `encoding` for.
+	literal_encoder with_encoding(encoding_t encoding) const noexcept {
+		literal_encoder result = *this;
+		result.m_encoding = encoding;
+		return result;
+	}
+
+	encoding_t encoding() const noexcept {
+		return m_encoding;
+	}
+
+	/// Size of the encoding of `size` bytes or more, for reserving memory.
+	std::size_t size_bound(std::size_t size) const noexcept {
+		if (external()) return 0;
+		if (m_encoding == encoding_t::words) return words_size(size) + 1;
+		if (m_encoding == encoding_t::string) return 4 * size + 4 * (size / string_chunk_size + 1);
+		if (m_wrap != 0) return wrapped_size(size, m_wrap);
+		return decimal_size_bound(size);
+	}
+
+	/// Encode the next block of data and append it to `out`.
+	void encode(std::span<const std::uint8_t> data, std::string& out) {
+		std::size_t old_size = out.size();
+
+		if (external()) {
+			// Contents are not part of the header
+		} else if (m_encoding == encoding_t::words) {
+			encode_words_block(data, out);
+		} else if (m_encoding == encoding_t::string) {
+			encode_string(data, m_offset, out);
+		} else if (m_wrap != 0) {
+			encode_decimal_wrapped(data, m_wrap, m_offset, out);
+		} else if (not data.empty()) {
+			// Every encoded byte is prefixed with a separator, except for the first byte of the file
+			if (m_offset == 0) {
+				const auto& first = detail::decimal_table[data[0]];
+				out.append(first.text.data() + 1, first.size - 1);
+				data = data.subspan(1);
+				m_offset += 1;
+			}
+			encode_decimal(data, out);
+		}
+
+		m_offset += data.size();
+		m_size += out.size() - old_size;
+	}
+
+	/// Encode what is left after the last block: the last, partial word with word encoding.
+	void finish(std::string& out) {
+		if (m_encoding == encoding_t::words and m_offset % 8 != 0) {
+			std::size_t old_size = out.size();
+			if (m_offset > 8) out.push_back(',');
+			out.resize(out.size() + word_literal_size);
+			detail::encode_word(std::span(m_word).first(m_offset % 8), out.data() + out.size() - word_literal_size);
+			m_size += out.size() - old_size;
+		}
+	}
+
+	/// Account for the next block of data without encoding it.
+	void skip(std::span<const std::uint8_t> data) {
+		if (external()) {
+			// Contents are not part of the header
+		} else if (m_encoding == encoding_t::words) {
+			m_size = words_size(m_offset + data.size());
+		} else if (m_encoding == encoding_t::string) {
+			m_size += string_size(data, m_offset);
+		} else if (m_wrap != 0) {
+			m_size += wrapped_size(m_offset + data.size(), m_wrap) - wrapped_size(m_offset, m_wrap);
+		} else if (not data.empty()) {
+			m_size += decimal_size(data) - (m_offset == 0 ? 1 : 0);
+		}
+
+		m_offset += data.size();
+	}
+
+	/// Size of the encoding of all blocks passed so far.
+	std::size_t size() const noexcept {
+		return m_size;
+	}
+
+	/**
+	 * @brief Encode complete file contents into a preallocated region, independently of the state of the encoder.
+	 *
+	 * Exactly as many characters are written as `encode` produces for the same contents.
+	 *
+	 * @return Pointer past the last character written.
+	 */
+	char* encode_all(std::span<const std::uint8_t> data, char* out) const noexcept {
+		if (external()) return out;
+		if (m_encoding == encoding_t::words) return encode_words(data, out);
+		if (m_encoding == encoding_t::string) return encode_string(data, 0, out);
+		if (m_wrap != 0) return encode_decimal_wrapped(data, m_wrap, 0, out);
+		return encode_decimal_list(data, out);
+	}
+
+	/// Beginning of the definition of the file at `path`, before its contents.
+	std::string definition_begin(std::size_t size, std::string_view name, std::string_view path) const {
+		if (m_blob) return std::string(blob_separator(size));
+		return fmt::format(template_file_guard_begin, name) + unguarded_definition_begin(size, name, path);
+	}
+
+	/// End of a file definition, after its contents.
+	std::string definition_end(std::size_t size, std::string_view name) const {
+		if (m_blob) return "";
+		return unguarded_definition_end(size, name) + std::string(template_file_guard_end);
+	}
+
+	/// Definition of a file of `size` zero bytes as zero-initialized storage, see `template_file_zeros_definition`.
+	std::string zeros_definition(std::size_t size, std::string_view name) const {
+		return fmt::format(template_file_zeros_definition, size, name);
+	}
+
+	/// Whether files of zero bytes are defined as zero-initialized storage, see `zero_file_min_size`.
+	bool elides_zeros() const noexcept {
+		return not external() and not m_blob;
+	}
+
+	/// Whether file contents are defined outside of the header, which only declares them.
+	bool external() const noexcept {
+		return m_encoding == encoding_t::incbin or m_encoding == encoding_t::object;
+	}
+
+	/// Beginning of a blob, an array named `name` that holds the contents of several files.
+	std::string blob_begin(std::string_view name) const {
+		std::string_view zero = m_encoding == encoding_t::string ? "\"\\0\"" : m_wrap == 0 ? "0" : "0,";
+		return fmt::format(template_blob_begin, name, zero);
+	}
+
+	/// Text before the contents of a file of `size` bytes in a blob, which the zero byte at its start allows.
+	std::string_view blob_separator(std::size_t size) const noexcept {
+		return m_encoding == encoding_t::decimal and m_wrap == 0 and size != 0 ? "," : "";
+	}
+
+	/// Specifier of the resource map: word encoding views words as bytes, which is not allowed at compile time.
+	std::string_view map_specifier() const noexcept {
+		return m_encoding == encoding_t::words ? "const" : "constexpr";
+	}
+
+	/**
+	 * @brief Name of the definition of a file with digest `hash` in namespace syringe, without the leading underscore.
+	 *
+	 * The name also names the guard of the definition. Word encoding defines contents that are only usable at runtime,
+	 * so its definitions are named apart from those of other encodings, which a constexpr resource map can refer to.
+	 */
+	std::string symbol(std::string_view hash) const {
+		if (m_encoding == encoding_t::words) return fmt::format("words_{}", hash);
+		return std::string(hash);
+	}
+
+	/// Template of the resource map in the runtime that the header uses.
+	std::string_view map_template() const noexcept {
+		return m_lite ? "lite_cxmap" : "cxmap";
+	}
+
+	/// Declaration of the storage of a file definition in a shard, see `template_shard_array_declaration`.
+	std::string storage_declaration(std::size_t size, std::string_view name) const {
+		switch (m_encoding) {
+			case encoding_t::string: return fmt::format(template_shard_data_declaration, size, name);
+			case encoding_t::embed: return fmt::format(template_shard_array_declaration, size, name);
+			default:
+				if (m_lite) return fmt::format(template_shard_data_declaration, size, name);
+				return fmt::format(template_shard_array_declaration, size, name);
+		}
+	}
+
+	/// Span of a file in the index of shards after the declaration of its storage, empty if the storage is an array.
+	std::string storage_span(std::size_t size, std::string_view name) const {
+		switch (m_encoding) {
+			case encoding_t::string: return fmt::format(template_shard_data_span, size, name);
+			case encoding_t::embed: return "";
+			default: return m_lite ? fmt::format(template_shard_data_span, size, name) : "";
+		}
+	}
+
+private:
+	/// Beginning of a file definition without its guard.
+	std::string unguarded_definition_begin(std::size_t size, std::string_view name, std::string_view path) const {
+		switch (m_encoding) {
+			case encoding_t::string: return fmt::format(template_file_string_definition_begin, size, name);
+			case encoding_t::words: return fmt::format(template_file_words_definition_begin, size, name);
+			case encoding_t::incbin:
+			case encoding_t::object: return fmt::format(template_file_incbin_definition, size, name);
+			case encoding_t::embed: {
+				std::string result;
+
+				// Header names have no escapes, a file with a path that can't be written as one only has the fallback
+				std::string embed_path = absolute_path(path);
+				if (embed_path.find_first_of("\"\n") == std::string::npos) {
+					result = fmt::format(template_file_embed_definition, size, name, embed_path);
+				}
+
+				result += fmt::format(template_file_embed_definition_begin, size, name);
+				return result;
+			}
+			default:
+				if (m_lite) return fmt::format(template_file_string_definition_begin, size, name);
+				return fmt::format(template_file_definition_begin, size, name);
+		}
+	}
+
+	/// End of a file definition without its guard.
+	std::string unguarded_definition_end(std::size_t size, std::string_view name) const {
+		std::string_view decimal_end =
+			m_wrap == 0 ? template_file_definition_end : template_file_definition_end_wrapped;
+
+		switch (m_encoding) {
+			case encoding_t::string: return fmt::format(template_file_string_definition_end, size, name);
+			case encoding_t::words: return fmt::format(template_file_words_definition_end, size, name);
+			case encoding_t::embed: return fmt::format(template_file_embed_definition_end, decimal_end, name);
+			case encoding_t::incbin:
+			case encoding_t::object: return "";
+			default:
+				if (m_lite) return fmt::format(template_file_string_definition_end, size, name);
+				return std::string(decimal_end);
+		}
+	}
+
+	/// Encode the words completed by the next block, keeping a trailing partial word for the next block.
+	void encode_words_block(std::span<const std::uint8_t> data, std::string& out) {
+		std::size_t offset = m_offset;
+
+		while (not data.empty()) {
+			std::size_t pending = offset % 8;
+			if (pending == 0 and data.size() >= 8) {
+				std::size_t count = data.size() / 8 * 8;
+				if (offset != 0) out.push_back(',');
+				out.resize(out.size() + words_size(count));
+				encode_words(data.first(count), out.data() + out.size() - words_size(count));
+
+				offset += count;
+				data = data.subspan(count);
+				continue;
+			}
+
+			std::size_t count = std::min(8 - pending, data.size());
+			std::copy_n(data.begin(), count, m_word.begin() + pending);
+			offset += count;
+			data = data.subspan(count);
+
+			if (offset % 8 == 0) {
+				if (offset > 8) out.push_back(',');
+				out.resize(out.size() + word_literal_size);
+				detail::encode_word(m_word, out.data() + out.size() - word_literal_size);
+			}
+		}
+	}
+
+	encoding_t m_encoding = encoding_t::decimal;
+	std::size_t m_wrap = 0;
+	bool m_blob = false;
+	bool m_lite = false;  ///< Definitions for the lite runtime, without `std::array`
+	std::size_t m_external_above = 0;
+	encoding_t m_external_encoding = encoding_t::incbin;  ///< Encoding of files above `m_external_above`
+	calibration_t m_calibration;  ///< Compile times that automatic encoding picks encodings by
+	std::size_t m_offset = 0;
+	std::size_t m_size = 0;
+	std::array<std::uint8_t, 8> m_word{};  ///< Bytes of the partial word at the end of the last block
+};
+
+/**
+ * @brief Name of a helper symbol of the resource map in namespace syringe, such as "_assets_resources_pool".
+ *
+ * The name is built from the qualified variable name, so that the generated headers of resource maps in different
+ * namespaces can be included in one translation unit.
+ */
+std::string helper_name(const InputConfig& config, std::string_view suffix) {
+	std::string result = "_";
+	for (std::size_t i = 0; i < config.namespace_name.size(); ++i) {
+		if (config.namespace_name.compare(i, 2, "::") == 0) {
+			result += '_';
+			++i;
+		} else {
+			result += config.namespace_name[i];
+		}
+	}
+	if (not config.namespace_name.empty()) result += '_';
+
+	return fmt::format("{}{}_{}", result, config.variable_name, suffix);
+}
+
+/// Wrap the definition of the file named `name` in a guard, see `template_file_guard_begin`.
+std::string guard_definition(std::string_view name, std::string_view definition) {
+	return fmt::format("{}{}{}", fmt::format(template_file_guard_begin, name), definition, template_file_guard_end);
+}
+
+/// Runtime of generated headers, which they contain or include, see `template_runtime` and `template_lite_runtime`.
+std::string runtime_header(bool lite = false) {
+	if (lite) return fmt::format(template_lite_runtime, fmt::format("{}{}", sorted_unique_tag, lite_cxmap));
+	return fmt::format(
+		template_runtime, fmt::format("{}{}", sorted_unique_tag, cxmap), fmt::format("{}{}", word_bytes, blob_map)
+	);
+}
+
+/// Beginning of a resource file, or of the data translation unit with `source_path`, up to the file definitions.
+std::string file_begin(const InputConfig& config) {
+	if (not config.source_path.empty()) return fmt::format(template_source_begin, config.source_header);
+	if (config.runtime_header.empty()) return fmt::format(template_file_begin, runtime_header(config.lite));
+	return fmt::format(template_file_begin, fmt::format(template_runtime_include, config.runtime_header));
+}
+
+/// Contents of a single input file, hashed and encoded in one pass.
+struct file_data_t {
+	std::string hash;
+	std::string symbol;  ///< Name of the file definition, see `literal_encoder::symbol`
+	std::size_t size = 0;
+	std::string cpp_data;  ///< Encoded file contents (only if encoded)
+	std::size_t cpp_size = 0;  ///< Size of encoded file contents, known even if the file was not encoded
+	bool zeros = false;  ///< Contents are all zero bytes and are defined without encoding, see `zero_file_min_size`
+	encoding_t encoding = encoding_t::decimal;  ///< Encoding of the contents, picked by `literal_encoder::routed`
+};
+
+/**
+ * @brief Hash and optionally encode data that is passed block by block.
+ *
+ * @param for_each_block function that calls its argument with consecutive blocks of data
+ * @param expected_size size of the data if known in advance, to encode without reallocations
+ * @param encoder encoder for the file's contents, routed by `expected_size`
+ * @param encode if false, only compute the hash and the encoded size
+ */
+template<typename ForEachBlock>
+file_data_t read_blocks(
+	ForEachBlock&& for_each_block, std::size_t expected_size, literal_encoder encoder, bool encode
+) {
 	namespace mm = mincemeat;
-	std::ifstream ifs(widen(path), std::ios::binary);
 
-	std::array<uint8_t, 10240> buffer;
 	mm::sha256_stream hasher;
+	file_data_t result;
+	bool zeros = encoder.elides_zeros();
+	encoder = encoder.routed(expected_size);
+	result.encoding = encoder.encoding();
 
-	do {
-		ifs.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
-		std::span data(buffer.begin(), ifs.gcount());
+	if (encode) result.cpp_data.reserve(encoder.size_bound(expected_size));
 
+	for_each_block([&](std::span<const std::uint8_t> data) {
+		result.size += data.size();
 		hasher << data;
-	} while (ifs);
+		zeros = zeros and all_zero(data);
+		if (encode) {
+			encoder.encode(data, result.cpp_data);
+		} else {
+			encoder.skip(data);
+		}
+	});
+
+	if (encode) encoder.finish(result.cpp_data);
+	result.cpp_size = encoder.size();
+	result.hash = mm::to_string(hasher.finish());
 
-	return mm::to_string(hasher.finish());
+	if (zeros and result.size >= zero_file_min_size) {
+		result.zeros = true;
+		result.cpp_data = {};
+		result.cpp_size = 0;
+	}
+
+	// Definitions of zero bytes do not depend on the encoding
+	result.symbol = result.zeros ? result.hash : encoder.symbol(result.hash);
+	return result;
 }
 
-/// Produce a file definition string for injecting into the template.
-std::string file_definition(std::string_view path, std::string_view hash) {
-	std::ifstream ifs(widen(path), std::ios::binary);
+/// Read a file once, feeding every block to the hasher and, if `encode` is set, to the literal encoder.
+file_data_t read_file(input_file& file, const literal_encoder& encoder = {}, bool encode = true) {
+	return read_blocks([&](auto&& callback) { file.for_each_block(callback); }, file.data().size(), encoder, encode);
+}
 
-	std::array<uint8_t, 10240> buffer;
-	std::stringstream cpp_data_stream;
-	std::size_t size = 0;
+file_data_t read_file(std::string_view path, const literal_encoder& encoder = {}, bool encode = true) {
+	input_file file(path);
+	return read_file(file, encoder, encode);
+}
 
-	std::string_view sep = "";
-	do {
-		ifs.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
-		size += ifs.gcount();
-		std::span data(buffer.begin(), ifs.gcount());
+/// Hash and encode file contents that are already in memory.
+file_data_t read_file(std::span<const std::uint8_t> contents, const literal_encoder& encoder = {}) {
+	return read_blocks([&](auto&& callback) { callback(contents); }, contents.size(), encoder, true);
+}
 
-		for (std::uint8_t byte : data) {
-			cpp_data_stream << sep << static_cast<int>(byte);
-			sep = ",";
-		}
-	} while (ifs);
+/// Encode a mapped file's contents block by block directly into the output.
+template<output_writer Writer>
+void write_file_data(Writer& out, input_file& file, literal_encoder encoder = {}) {
+	std::string cpp_data;
+
+	file.for_each_block([&](std::span<const std::uint8_t> data) {
+		cpp_data.clear();
+		encoder.encode(data, cpp_data);
+		out.write(cpp_data);
+	});
 
-	std::string cpp_data = cpp_data_stream.str();
-	return fmt::format(template_file_definition, cpp_data, size, hash);
+	cpp_data.clear();
+	encoder.finish(cpp_data);
+	out.write(cpp_data);
 }
 
 /// Produce a file usage string for injecting into the template.
-std::string file_usage(std::string_view display_path, std::string_view hash) {
-	return fmt::format(template_file_usage, display_path, hash);
+std::string file_usage(std::string_view display_path, std::string_view name) {
+	return fmt::format(template_file_usage, display_path, name);
 }
 
-struct syringe_impl_result_t {
-	std::vector<std::string> definitions;
-	std::vector<std::string> usages;
-	std::unordered_set<std::string> hashes;
+/// An input file after processing, before it is written into the output.
+struct processed_file_t {
+	file_data_t data;
+	std::unique_ptr<input_file> unbuffered;  ///< Mapped file that has to be encoded straight into the output
 };
 
-syringe_impl_result_t syringe_impl(const InputConfig& config) {
-	syringe_impl_result_t r;
+/// Paths of input files and their display paths, in the order in which they are processed.
+struct input_list_t {
+	std::vector<const std::string*> paths;
+	std::vector<const std::string*> display_paths;
+};
 
-	for (auto& [path, display_path] : config.paths) {
-		std::string hash = file_hash(path);
-		auto [_, is_new] = r.hashes.insert(hash);
+/**
+ * @brief List input files in canonical order, sorted by display path.
+ *
+ * `InputConfig::paths` is a hash map whose iteration order depends on the standard library and on insertion order.
+ * Processing files in sorted order makes the output depend only on the inputs themselves.
+ */
+input_list_t sorted_inputs(const InputConfig& config) {
+	std::vector<const std::pair<const std::string, std::string>*> entries;
+	entries.reserve(config.paths.size());
+	for (const auto& entry : config.paths) entries.push_back(&entry);
 
-		if (is_new) r.definitions.push_back(file_definition(path, hash));
-		r.usages.push_back(file_usage(display_path, hash));
+	std::ranges::sort(entries, [](const auto* lhs, const auto* rhs) {
+		return std::tie(lhs->second, lhs->first) < std::tie(rhs->second, rhs->first);
+	});
+
+	input_list_t result;
+	result.paths.reserve(entries.size());
+	result.display_paths.reserve(entries.size());
+	for (const auto* entry : entries) {
+		result.paths.push_back(&entry->first);
+		result.display_paths.push_back(&entry->second);
 	}
 
-	return r;
+	return result;
 }
 
-void syringe(const InputConfig& config, FILE* fp) {
-	auto [definitions, usages, hashes] = syringe_impl(config);
+/// A file usage before formatting, kept until all files are processed.
+struct usage_t {
+	const std::string* display_path;
+	std::string symbol;  ///< Name of the file definition, see `literal_encoder::symbol`
 
-	fmt::print(
-		fp,
-		template_file,
+	bool operator==(const usage_t& other) const {
+		return *display_path == *other.display_path and symbol == other.symbol;
+	}
+
+	auto operator<=>(const usage_t& other) const {
+		return std::tie(*display_path, symbol) <=> std::tie(*other.display_path, other.symbol);
+	}
+};
+
+/**
+ * @brief Sort usages by display path, then by definition name, and keep one usage per display path: the last one.
+ *
+ * The result is in the order of keys in a cxmap, so the map can be initialized without sorting at compile time.
+ */
+std::vector<const usage_t*> map_entries(std::vector<usage_t>& usages) {
+	std::ranges::sort(usages);
+
+	std::vector<const usage_t*> result;
+	for (const usage_t& usage : usages) {
+		if (not result.empty() and *result.back()->display_path == *usage.display_path) {
+			result.back() = &usage;
+		} else {
+			result.push_back(&usage);
+		}
+	}
+
+	return result;
+}
+
+/// Format the entries of the resource map for the template, in the order of `map_entries`.
+std::string format_usages(std::span<const usage_t* const> entries) {
+	std::string result;
+	for (const usage_t* entry : entries) {
+		result += "\n";
+		result += file_usage(*entry->display_path, entry->symbol);
+	}
+
+	return result;
+}
+
+/**
+ * @brief Index of the files in a blob, built while their contents are written into it.
+ *
+ * The blob starts with a zero byte, files follow in the order in which they are added.
+ */
+class blob_index_t {
+public:
+	/// Add the contents of the next file.
+	void add(const std::string& hash, std::size_t size) {
+		m_files.emplace(hash, std::pair(m_size, size));
+		m_size += size;
+	}
+
+	/// Format the key table, the index and the resource map, from the end of the blob to the end of the file.
+	std::string format(const InputConfig& config, std::vector<usage_t>& usages) const {
+		std::vector<const usage_t*> entries = map_entries(usages);
+
+		std::string rows;
+		std::string row;
+		std::size_t row_count = 0;
+		std::size_t row_offset = 0;
+		auto end_row = [&]() {
+			rows += fmt::format("\n\t\"{}\",", row);
+			row.clear();
+			row_count += 1;
+			row_offset = 0;
+		};
+
+		std::string index;
+		for (const usage_t* entry : entries) {
+			const std::string& key = *entry->display_path;
+
+			// Every row ends with the null terminator of its string literal
+			if (key.size() >= blob_key_row_size) {
+				throw std::runtime_error(fmt::format("path is too long for the blob layout: {}", key));
+			}
+			if (row_offset + key.size() >= blob_key_row_size) end_row();
+
+			std::size_t key_offset = row_count * blob_key_row_size + row_offset;
+			for (char c : key) {
+				if (c == '?') {
+					row += "\\?";  // Never a trigraph
+				} else {
+					const auto& escape = detail::string_escape_table[static_cast<std::uint8_t>(c)];
+					row.append(escape.padded.data(), escape.padded_size);
+				}
+			}
+			row_offset += key.size();
+
+			auto [data_offset, data_size] = m_files.at(entry->symbol);
+			index += fmt::format("\n\t{{{}, {}, {}, {}}},", key_offset, key.size(), data_offset, data_size);
+		}
+		if (row_offset != 0) end_row();
+
+		bool small = std::max(m_size, row_count * blob_key_row_size) <= std::numeric_limits<std::uint32_t>::max();
+		return fmt::format(
+			template_blob_index,
+			config.namespace_name.empty() ? "" : fmt::format("namespace {} {{\n\n", config.namespace_name),
+			config.variable_name,
+			entries.size(),
+			rows,
+			std::max<std::size_t>(row_count, 1),
+			blob_key_row_size,
+			index,
+			std::max<std::size_t>(entries.size(), 1),
+			small ? "std::uint32_t" : "std::uint64_t",
+			config.namespace_name.empty() ? "" : fmt::format("\n\n}}  // namespace {}", config.namespace_name),
+			helper_name(config, "")
+		);
+	}
+
+private:
+	std::unordered_map<std::string, std::pair<std::size_t, std::size_t>> m_files;  ///< Offset and size by digest
+	std::size_t m_size = 1;
+};
+
+/// Format the end of a resource file after the definitions of files, up to the end of the file.
+std::string format_resource_map(
+	const InputConfig& config, const literal_encoder& encoder, std::vector<usage_t>& usages, const blob_index_t& blob
+) {
+	if (config.blob) return std::string(template_blob_end) + blob.format(config, usages);
+
+	std::vector<const usage_t*> entries = map_entries(usages);
+	std::string result = fmt::format(
+		template_file_middle,
 		config.namespace_name.empty() ? "" : fmt::format("namespace {} {{\n\n", config.namespace_name),
-		config.namespace_name.empty() ? "" : fmt::format("\n\n}}  // namespace {}", config.namespace_name),
 		config.variable_name,
-		config.paths.size(),
-		join(definitions, "\n"),
-		join(usages, "\n"),
-		cxmap
+		entries.size(),
+		encoder.map_specifier(),
+		encoder.map_template()
 	);
+	result += format_usages(entries);
+	result += fmt::format(
+		template_file_end,
+		config.namespace_name.empty() ? "" : fmt::format("\n\n}}  // namespace {}", config.namespace_name)
+	);
+
+	return result;
 }
 
-[[nodiscard]] std::string syringe(const InputConfig& config) {
-	auto [definitions, usages, hashes] = syringe_impl(config);
+/**
+ * @brief Format the declaration-only header of the data translation unit at `InputConfig::source_path`.
+ *
+ * The header only depends on the display paths of files, not on their contents.
+ */
+std::string declaration_header(const InputConfig& config) {
+	input_list_t inputs = sorted_inputs(config);
+	std::size_t map_size = 0;
+	for (std::size_t i = 0; i < inputs.display_paths.size(); ++i) {
+		if (i == 0 or *inputs.display_paths[i] != *inputs.display_paths[i - 1]) ++map_size;
+	}
 
+	std::string runtime = config.runtime_header.empty()
+		? runtime_header(config.lite)
+		: fmt::format(template_runtime_include, config.runtime_header);
 	return fmt::format(
-		template_file,
+		template_declaration_file,
+		runtime,
 		config.namespace_name.empty() ? "" : fmt::format("namespace {} {{\n\n", config.namespace_name),
-		config.namespace_name.empty() ? "" : fmt::format("\n\n}}  // namespace {}", config.namespace_name),
 		config.variable_name,
-		config.paths.size(),
-		join(definitions, "\n"),
-		join(usages, "\n"),
-		cxmap
+		map_size,
+		literal_encoder(config).map_template(),
+		config.namespace_name.empty() ? "" : fmt::format("\n\n}}  // namespace {}", config.namespace_name)
+	);
+}
+
+/**
+ * @brief Small files, defined together in one blob after all other definitions.
+ *
+ * Files smaller than `InputConfig::pool_below` are added to the pool instead of being defined one by one, which saves
+ * a definition and a symbol per file.
+ */
+class small_file_pool_t {
+public:
+	small_file_pool_t(const InputConfig& config, const literal_encoder& encoder) :
+		m_name(helper_name(config, "pool")), m_limit(config.pool_below), m_encoder(encoder) {}
+
+	/// Whether a file of `size` bytes belongs in the pool.
+	bool accepts(std::size_t size) const noexcept {
+		return size < m_limit;
+	}
+
+	/// Add a file to the pool. Files that were not encoded in memory are read again from `path`.
+	void add(const file_data_t& data, std::string_view path) {
+		m_contents += m_encoder.blob_separator(data.size);
+		if (data.cpp_data.size() == data.cpp_size) {
+			m_contents += data.cpp_data;
+		} else {
+			m_contents += read_file(path, m_encoder).cpp_data;
+		}
+
+		m_definitions += '\n';
+		m_definitions += guard_definition(
+			data.symbol, fmt::format(template_pool_file_definition, data.size, data.symbol, m_name, m_size)
+		);
+		m_size += data.size;
+	}
+
+	/// Format the pool and the definitions of its files, after `separator`. Empty if the pool is empty.
+	std::string format(std::string_view separator) const {
+		if (m_definitions.empty()) return "";
+		return fmt::format(
+			"{}{}{}{}{}", separator, m_encoder.blob_begin(m_name), m_contents, template_blob_end, m_definitions
+		);
+	}
+
+private:
+	std::string m_name;
+	std::size_t m_limit;
+	literal_encoder m_encoder;
+	std::string m_contents;
+	std::string m_definitions;
+	std::size_t m_size = 1;  // The pool starts with a zero byte
+};
+
+/// Number of files processed together by one worker. Small files of a batch are read with batched I/O.
+constexpr std::size_t batch_file_count = 64;
+
+/**
+ * @brief Hash and encode a batch of files.
+ *
+ * Small regular files are read together by `read_small_files`, the rest are mapped one by one. At most
+ * `buffer_budget` bytes of mapped files are encoded in memory per batch, the rest stay mapped and are only hashed, to
+ * be encoded straight into the output.
+ */
+std::vector<processed_file_t> process_batch(
+	std::span<const std::string* const> paths,
+	const literal_encoder& encoder,
+	std::uintmax_t buffer_budget = buffered_file_limit
+) {
+	file_batch_t small_files = read_small_files(paths);
+
+	std::vector<processed_file_t> result;
+	result.reserve(paths.size());
+
+	for (std::size_t i = 0; i < paths.size(); ++i) {
+		if (small_files.contents[i]) {
+			result.push_back({read_file(*small_files.contents[i], encoder), nullptr});
+			continue;
+		}
+
+		auto file = std::make_unique<input_file>(*paths[i]);
+		bool buffered = not file->mapped() or file->data().size() <= buffer_budget;  // Special files can't be re-read
+		if (file->mapped() and buffered) buffer_budget -= file->data().size();
+
+		// Files of zero bytes are not encoded, which is cheap to check up front for mapped files
+		if (file->mapped() and encoder.elides_zeros() and all_zero(file->data())) buffered = false;
+
+		result.push_back({read_file(*file, encoder, buffered), nullptr});
+		const file_data_t& data = result.back().data;
+		bool external = encoder.with_encoding(data.encoding).external();
+		if (not buffered and not data.zeros and not external) result.back().unbuffered = std::move(file);
+	}
+
+	return result;
+}
+
+/// Check if two files exist and have the same contents.
+bool same_file_contents(std::string_view lhs_path, std::string_view rhs_path) {
+	std::error_code ec;
+	if (not std::filesystem::is_regular_file(widen(lhs_path), ec)) return false;
+	if (not std::filesystem::is_regular_file(widen(rhs_path), ec)) return false;
+
+	input_file lhs(lhs_path);
+	input_file rhs(rhs_path);
+	if (lhs.mapped() and rhs.mapped()) return std::ranges::equal(lhs.data(), rhs.data());
+
+	// Files of size 0 are not mapped. Outputs are never pseudo-files, so they are equal if both are empty.
+	auto lhs_size = std::filesystem::file_size(widen(lhs_path), ec);
+	return lhs_size == 0 and std::filesystem::file_size(widen(rhs_path), ec) == 0;
+}
+
+/**
+ * @brief Write a file by calling `generate(temp_path)`, then replace `path` with it only if its contents change.
+ *
+ * The temporary file is in the same directory as `path`. It is removed if the existing file has the same contents, or
+ * atomically renamed over it otherwise.
+ */
+template<typename Generate>
+void replace_if_changed(std::string_view path, Generate&& generate) {
+	std::string temp_path = fmt::format("{}.{:08x}.tmp", path, std::random_device()());
+
+	try {
+		generate(std::string_view(temp_path));
+
+		if (same_file_contents(temp_path, path)) {
+			std::filesystem::remove(widen(temp_path));
+		} else {
+			std::filesystem::rename(widen(temp_path), widen(path));
+		}
+	} catch (...) {
+		std::error_code ec;
+		std::filesystem::remove(widen(temp_path), ec);
+		throw;
+	}
+}
+
+/// Write the file at `path` by calling `generate(out)` with a `file_writer`, replacing it only if its contents change.
+template<typename Generate>
+void stream_if_changed(std::string_view path, Generate&& generate) {
+	replace_if_changed(path, [&](std::string_view temp_path) {
+		auto file_close = [](FILE* fp) { std::fclose(fp); };
+		std::unique_ptr<FILE, decltype(file_close)> fp(std::fopen(std::string(temp_path).c_str(), "wb"), file_close);
+		if (fp == nullptr) throw std::runtime_error(fmt::format("could not open output file: {}", temp_path));
+
+		file_writer out(fp.get());
+		generate(out);
+		out.flush();
+	});
+}
+
+/// Write `text` to the file at `path`, which is only replaced if its contents change.
+void write_if_changed(std::string_view path, std::string_view text) {
+	stream_if_changed(path, [&](file_writer& out) { out.write(text); });
+}
+
+/// A file with contents defined outside of the header, by an assembly or object file.
+struct external_file_t {
+	std::string hash;
+	std::size_t size;
+	std::string path;  ///< Absolute path with forward slashes
+};
+
+/**
+ * @brief Write the assembly file that defines the symbols declared by a header with incbin encoding.
+ *
+ * The file is only replaced if its contents change.
+ */
+void write_assembly(std::string_view path, std::span<const external_file_t> files) {
+	std::string text = fmt::format(template_assembly_begin);
+	for (const external_file_t& file : files) {
+		std::string escaped_path;
+		for (char c : file.path) {
+			if (c == '"' or c == '\\') escaped_path += '\\';
+			escaped_path += c == '\n' ? std::string_view("\\n") : std::string_view(&c, 1);
+		}
+
+		text += fmt::format(template_assembly_file, file.hash, file.size, escaped_path);
+	}
+	text += template_assembly_end;
+
+	write_if_changed(path, text);
+}
+
+/**
+ * @brief Write the object file for `machine` that defines the symbols declared by a header with object encoding.
+ *
+ * File contents are copied into the object on `jobs` threads. The file is only replaced if its contents change.
+ */
+void write_object(std::string_view path, std::span<const external_file_t> files, std::uint16_t machine, unsigned jobs) {
+	std::vector<elf::data_symbol_t> symbols;
+	for (const external_file_t& file : files) symbols.push_back({"syringe_" + file.hash, file.size});
+	elf::object_layout layout(symbols, machine);
+
+	replace_if_changed(path, [&](std::string_view temp_path) {
+		output_mapping output(temp_path, layout.size());
+		char* out = output.data().data();
+		layout.write_headers(out);
+
+		parallel_for(files.size(), jobs, [&](std::size_t i) {
+			input_file file(files[i].path);
+			std::size_t offset = 0;
+			file.for_each_block([&](std::span<const std::uint8_t> block) {
+				if (offset + block.size() > files[i].size) return;
+				std::copy(block.begin(), block.end(), out + layout.data_offset(i) + offset);
+				offset += block.size();
+			});
+
+			if (offset != files[i].size) {
+				throw std::runtime_error(fmt::format("file changed while generating output: {}", files[i].path));
+			}
+		});
+	});
+}
+
+/// Write the file that defines the contents declared by a header with incbin or object encoding, or `external_above`.
+void write_external_files(const InputConfig& config, std::span<const external_file_t> files) {
+	encoding_t encoding = external_encoding(config);
+	if (encoding != config.encoding and config.external_above == 0) return;
+
+	if (encoding == encoding_t::incbin) write_assembly(config.assembly_path, files);
+	if (encoding == encoding_t::object) {
+		write_object(config.object_path, files, config.object_machine, config.jobs == 0 ? default_jobs() : config.jobs);
+	}
+}
+
+/**
+ * @brief Generate a resource file, writing it piece by piece.
+ *
+ * Files are hashed and encoded in batches on `config.jobs` threads, then written in the order of `sorted_inputs`, so
+ * the output does not depend on the number of threads or on the order of `config.paths`. Definitions are written in
+ * the order of their first usage, usages are sorted by display path and digest. Only usages, which are small, are kept
+ * until the end. Mapped files above `buffered_file_limit` are encoded straight into the output, so memory use does not
+ * depend on the size of the input.
+ */
+template<output_writer Writer>
+void syringe_write(const InputConfig& config, Writer& out) {
+	const literal_encoder encoder(config);
+	out.write(file_begin(config));
+	if (config.blob) out.write(encoder.blob_begin(helper_name(config, "blob")));
+
+	input_list_t inputs = sorted_inputs(config);
+	const auto& paths = inputs.paths;
+	const auto& display_paths = inputs.display_paths;
+
+	std::unordered_set<std::string> hashes;
+	std::vector<usage_t> usages;
+	std::vector<external_file_t> external_files;
+	blob_index_t blob_index;
+	small_file_pool_t pool(config, encoder);
+	std::string_view separator = "";
+
+	ordered_parallel_for<std::vector<processed_file_t>>(
+		(paths.size() + batch_file_count - 1) / batch_file_count,
+		config.jobs == 0 ? default_jobs() : config.jobs,
+		[&](std::size_t batch) {
+			std::size_t first = batch * batch_file_count;
+			return process_batch(
+				std::span(paths).subspan(first, std::min(batch_file_count, paths.size() - first)), encoder
+			);
+		},
+		[&](std::size_t batch, std::vector<processed_file_t> files) {
+			for (std::size_t i = 0; i < files.size(); ++i) {
+				processed_file_t& file = files[i];
+				const literal_encoder file_encoder = encoder.with_encoding(file.data.encoding);
+				auto [_, is_new] = hashes.insert(file.data.symbol);
+
+				// The encoded data of duplicate files is discarded, only the usage refers to the existing definition
+				if (is_new and file.data.zeros) {
+					out.write(separator);
+					out.write(
+						guard_definition(file.data.symbol, encoder.zeros_definition(file.data.size, file.data.symbol))
+					);
+					separator = "\n";
+				} else if (is_new and pool.accepts(file.data.size) and not file_encoder.external()) {
+					pool.add(file.data, *paths[batch * batch_file_count + i]);
+				} else if (is_new) {
+					out.write(separator);
+					out.write(file_encoder.definition_begin(
+						file.data.size, file.data.symbol, *paths[batch * batch_file_count + i]
+					));
+					if (file.unbuffered) {
+						write_file_data(out, *file.unbuffered, file_encoder);
+					} else {
+						out.write(file.data.cpp_data);
+					}
+					out.write(file_encoder.definition_end(file.data.size, file.data.symbol));
+					separator = config.blob ? "" : "\n";
+					if (config.blob) blob_index.add(file.data.symbol, file.data.size);
+
+					if (file_encoder.external()) {
+						external_files.push_back(
+							{file.data.symbol, file.data.size, absolute_path(*paths[batch * batch_file_count + i])}
+						);
+					}
+				}
+
+				usages.push_back({display_paths[batch * batch_file_count + i], file.data.symbol});
+			}
+		}
 	);
+
+	out.write(pool.format(separator));
+	out.write(format_resource_map(config, encoder, usages, blob_index));
+	write_external_files(config, external_files);
+}
+
+/**
+ * @brief Generate a resource file into a preallocated, memory-mapped output file.
+ *
+ * All files are hashed first, which determines the size of every definition and therefore the complete layout of the
+ * output. The file is then allocated and mapped, and every definition is encoded by a worker thread directly into its
+ * own region. Mapped input files are read a second time for this, which is usually served from the page cache.
+ */
+void syringe_mapped(const InputConfig& config, std::string_view output_path) {
+	struct definition_t {
+		const std::string* path;
+		processed_file_t file;
+		std::size_t data_offset = 0;
+	};
+
+	input_list_t inputs = sorted_inputs(config);
+	const auto& paths = inputs.paths;
+	const auto& display_paths = inputs.display_paths;
+	const unsigned jobs = config.jobs == 0 ? default_jobs() : config.jobs;
+	const literal_encoder encoder(config);
+
+	// Hash files and compute the layout ------------------------------------------------------------------------------
+	std::string text = file_begin(config);
+	if (config.blob) text += encoder.blob_begin(helper_name(config, "blob"));
+	std::vector<std::pair<std::size_t, std::string>> texts;  // Fixed parts of the output and their offsets
+	std::size_t offset = text.size();
+	texts.emplace_back(0, std::move(text));
+
+	std::unordered_set<std::string> hashes;
+	std::vector<definition_t> definitions;
+	std::vector<usage_t> usages;
+	blob_index_t blob_index;
+	small_file_pool_t pool(config, encoder);
+	std::string_view separator = "";
+
+	ordered_parallel_for<std::vector<processed_file_t>>(
+		(paths.size() + batch_file_count - 1) / batch_file_count,
+		jobs,
+		[&](std::size_t batch) {
+			std::size_t first = batch * batch_file_count;
+			return process_batch(
+				std::span(paths).subspan(first, std::min(batch_file_count, paths.size() - first)), encoder, 0
+			);
+		},
+		[&](std::size_t batch, std::vector<processed_file_t> files) {
+			for (std::size_t i = 0; i < files.size(); ++i) {
+				processed_file_t& file = files[i];
+				std::size_t index = batch * batch_file_count + i;
+				const literal_encoder file_encoder = encoder.with_encoding(file.data.encoding);
+				usages.push_back({display_paths[index], file.data.symbol});
+				auto [_, is_new] = hashes.insert(file.data.symbol);
+
+				if (is_new and file.data.zeros) {
+					text = separator;
+					text += guard_definition(
+						file.data.symbol, encoder.zeros_definition(file.data.size, file.data.symbol)
+					);
+					std::size_t text_size = text.size();
+					texts.emplace_back(offset, std::move(text));
+					offset += text_size;
+					separator = "\n";
+				} else if (is_new and pool.accepts(file.data.size) and not file_encoder.external()) {
+					pool.add(file.data, *paths[index]);
+				} else if (is_new) {
+					text = separator;
+					text += file_encoder.definition_begin(file.data.size, file.data.symbol, *paths[index]);
+					std::size_t text_size = text.size();
+					texts.emplace_back(offset, std::move(text));
+					offset += text_size;
+
+					// Mapped files are encoded again in the second pass, no need to keep them open until then
+					file.unbuffered.reset();
+					definitions.push_back({paths[index], std::move(file), offset});
+					const file_data_t& data = definitions.back().file.data;
+					offset += data.cpp_size;
+
+					text = file_encoder.definition_end(data.size, data.symbol);
+					text_size = text.size();
+					texts.emplace_back(offset, std::move(text));
+					offset += text_size;
+					separator = config.blob ? "" : "\n";
+					if (config.blob) blob_index.add(data.symbol, data.size);
+				}
+			}
+		}
+	);
+
+	text = pool.format(separator);
+	text += format_resource_map(config, encoder, usages, blob_index);
+	std::size_t text_size = text.size();
+	texts.emplace_back(offset, std::move(text));
+	offset += text_size;
+
+	// Write the output -----------------------------------------------------------------------------------------------
+	output_mapping output(output_path, offset);
+	char* out = output.data().data();
+
+	for (auto& [text_offset, text] : texts) std::copy(text.begin(), text.end(), out + text_offset);
+
+	parallel_for(definitions.size(), jobs, [&](std::size_t i) {
+		definition_t& definition = definitions[i];
+		char* region = out + definition.data_offset;
+
+		if (not definition.file.data.cpp_data.empty() or definition.file.data.cpp_size == 0) {
+			std::copy(definition.file.data.cpp_data.begin(), definition.file.data.cpp_data.end(), region);
+			return;
+		}
+
+		input_file file(*definition.path);
+		char* end = encoder.with_encoding(definition.file.data.encoding).encode_all(file.data(), region);
+		if (not file.mapped() or static_cast<std::size_t>(end - region) != definition.file.data.cpp_size) {
+			throw std::runtime_error(fmt::format("file changed while generating output: {}", *definition.path));
+		}
+	});
+
+	std::vector<external_file_t> external_files;
+	for (const definition_t& definition : definitions) {
+		const file_data_t& data = definition.file.data;
+		if (encoder.with_encoding(data.encoding).external()) {
+			external_files.push_back({data.symbol, data.size, absolute_path(*definition.path)});
+		}
+	}
+	write_external_files(config, external_files);
+}
+
+/// Path of shard `i` of the data translation unit at `source_path`, such as "resources_0.cpp" for "resources.cpp".
+std::string shard_path(std::string_view source_path, std::size_t i) {
+	std::size_t dot = source_path.rfind('.');
+	std::size_t slash = source_path.find_last_of("/\\");
+	if (dot == std::string_view::npos or (slash != std::string_view::npos and dot < slash)) dot = source_path.size();
+	return fmt::format("{}_{}{}", source_path.substr(0, dot), i, source_path.substr(dot));
+}
+
+/**
+ * @brief Shard that defines a file first used at `display_path`.
+ *
+ * The shard only depends on the path, so changing the contents of a file only changes its own shard and the index.
+ */
+std::size_t shard_of(std::string_view display_path, std::size_t shards) noexcept {
+	std::uint64_t hash = 0xcbf29ce484222325;  // FNV-1a
+	for (char c : display_path) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 0x100000001b3;
+	}
+
+	return hash % shards;
+}
+
+/**
+ * @brief Generate the data translation unit at `source_path` as an index and `shards` translation units with the file
+ * definitions, which are compiled in parallel.
+ *
+ * All files are hashed first, which is enough to write the index: storage declarations of the files in shards, the
+ * definitions of zero files, the small file pool, external files, and the resource map. The shards are then encoded
+ * on `config.jobs` threads, one shard per thread, reading mapped files a second time as `syringe_mapped` does. Every
+ * file is only replaced if its contents change.
+ */
+void syringe_shards(const InputConfig& config) {
+	struct definition_t {
+		const std::string* path;
+		file_data_t data;
+	};
+
+	input_list_t inputs = sorted_inputs(config);
+	const auto& paths = inputs.paths;
+	const auto& display_paths = inputs.display_paths;
+	const unsigned jobs = config.jobs == 0 ? default_jobs() : config.jobs;
+	const literal_encoder encoder(config);
+
+	// Hash files and write the index ---------------------------------------------------------------------------------
+	std::string index = file_begin(config);
+	std::vector<std::vector<definition_t>> shards(config.shards);
+	std::unordered_set<std::string> hashes;
+	std::vector<usage_t> usages;
+	std::vector<external_file_t> external_files;
+	small_file_pool_t pool(config, encoder);
+	std::string_view separator = "";
+
+	ordered_parallel_for<std::vector<processed_file_t>>(
+		(paths.size() + batch_file_count - 1) / batch_file_count,
+		jobs,
+		[&](std::size_t batch) {
+			std::size_t first = batch * batch_file_count;
+			return process_batch(
+				std::span(paths).subspan(first, std::min(batch_file_count, paths.size() - first)), encoder, 0
+			);
+		},
+		[&](std::size_t batch, std::vector<processed_file_t> files) {
+			for (std::size_t i = 0; i < files.size(); ++i) {
+				file_data_t& data = files[i].data;
+				std::size_t file_index = batch * batch_file_count + i;
+				const literal_encoder file_encoder = encoder.with_encoding(data.encoding);
+				usages.push_back({display_paths[file_index], data.symbol});
+				auto [_, is_new] = hashes.insert(data.symbol);
+				if (not is_new) continue;
+
+				if (pool.accepts(data.size) and not data.zeros and not file_encoder.external()) {
+					pool.add(data, *paths[file_index]);
+					continue;
+				}
+
+				index += separator;
+				separator = "\n";
+				if (data.zeros) {
+					index += guard_definition(data.symbol, encoder.zeros_definition(data.size, data.symbol));
+				} else if (file_encoder.external()) {
+					index += file_encoder.definition_begin(data.size, data.symbol, *paths[file_index]);
+					index += file_encoder.definition_end(data.size, data.symbol);
+					external_files.push_back({data.symbol, data.size, absolute_path(*paths[file_index])});
+				} else {
+					index += file_encoder.storage_declaration(data.size, data.symbol);
+					std::string span = file_encoder.storage_span(data.size, data.symbol);
+					if (not span.empty()) index += "\n" + span;
+
+					std::size_t shard = shard_of(*display_paths[file_index], shards.size());
+					shards[shard].push_back({paths[file_index], std::move(data)});
+				}
+			}
+		}
+	);
+
+	index += pool.format(separator);
+	index += format_resource_map(config, encoder, usages, {});
+
+	// Write the shards and the index ---------------------------------------------------------------------------------
+	parallel_for(shards.size(), jobs, [&](std::size_t shard) {
+		stream_if_changed(shard_path(config.source_path, shard), [&](file_writer& out) {
+			out.write(file_begin(config));
+			std::string_view definition_separator = "";
+			for (const definition_t& definition : shards[shard]) {
+				const file_data_t& data = definition.data;
+				const literal_encoder file_encoder = encoder.with_encoding(data.encoding);
+				out.write(definition_separator);
+				out.write(file_encoder.storage_declaration(data.size, data.symbol));
+				out.write("\n");
+				out.write(file_encoder.definition_begin(data.size, data.symbol, *definition.path));
+
+				if (not data.cpp_data.empty() or data.cpp_size == 0) {
+					out.write(data.cpp_data);
+				} else {
+					input_file file(*definition.path);
+					if (not file.mapped() or file.data().size() != data.size) {
+						throw std::runtime_error(
+							fmt::format("file changed while generating output: {}", *definition.path)
+						);
+					}
+					write_file_data(out, file, file_encoder);
+				}
+
+				out.write(file_encoder.definition_end(data.size, data.symbol));
+				definition_separator = "\n";
+			}
+			out.write(template_shard_end);
+		});
+	});
+
+	write_if_changed(config.source_path, index);
+	write_external_files(config, external_files);
+}
+
+void syringe(const InputConfig& config, FILE* fp) {
+	file_writer out(fp);
+	syringe_write(config, out);
+	out.flush();
+}
+
+[[nodiscard]] std::string syringe(const InputConfig& config) {
+	std::string result;
+	string_writer out(result);
+	syringe_write(config, out);
+
+	return result;
+}
+
+/// Generate a resource file at `output_path`, through a memory mapping if `mapped_output` is set.
+void syringe(const InputConfig& config, std::string_view output_path, bool mapped_output) {
+	if (mapped_output) {
+		syringe_mapped(config, output_path);
+		return;
+	}
+
+	auto file_close = [](FILE* fp) { std::fclose(fp); };
+	std::unique_ptr<FILE, decltype(file_close)> fp(std::fopen(std::string(output_path).c_str(), "w"), file_close);
+	if (fp == nullptr) throw std::runtime_error(fmt::format("could not open output file: {}", output_path));
+
+	syringe(config, fp.get());
+}
+
+/**
+ * @brief Generate a resource file at `output_path`, replacing the existing file only if its contents change.
+ *
+ * The output is never left partially written, and its modification time only changes with its contents, so build
+ * systems that check it can skip dependent steps.
+ */
+void syringe_if_changed(const InputConfig& config, std::string_view output_path, bool mapped_output) {
+	replace_if_changed(output_path, [&](std::string_view temp_path) { syringe(config, temp_path, mapped_output); });
+}
+
+// Calibration run =====================================================================================================
+/// Random files of one size that a calibration run compiles together, as one sample per encoding.
+struct calibration_sample_t {
+	std::size_t count;
+	std::size_t size;
+};
+
+/// Samples of a calibration run. Many small files measure the time per definition, large files the time per MiB.
+constexpr std::array<calibration_sample_t, 5> calibration_samples = {{
+	{1024, 64},
+	{256, 1024},
+	{1, 64 * 1024},
+	{1, 1024 * 1024},
+	{1, 4 * 1024 * 1024},
+}};
+
+/// Number of times that every sample is compiled, the median time is used.
+constexpr std::size_t calibration_runs = 5;
+
+/// Time a compilation of `source` by `compiler` without code generation, nullopt if it failed.
+std::optional<double> time_compile(
+	std::string_view compiler, std::string_view compiler_id, const std::filesystem::path& source
+) {
+	std::string command = compiler_id == "MSVC"
+		? fmt::format(R"("{}" /nologo /std:c++20 /Zs "{}")", compiler, source.string())
+		: fmt::format(R"("{}" -std=c++20 -fsyntax-only "{}")", compiler, source.string());
+#ifdef _WIN32
+	command = fmt::format(R"("{} >nul 2>&1")", command);  // cmd removes the outer quotes
+#else
+	command += " >/dev/null 2>&1";
+#endif
+
+	auto start = std::chrono::steady_clock::now();
+	if (std::system(command.c_str()) != 0) return std::nullopt;
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/// Median time of `calibration_runs` compilations of `source`, nullopt if the first one failed.
+std::optional<double> median_compile_time(
+	std::string_view compiler, std::string_view compiler_id, const std::filesystem::path& source
+) {
+	std::vector<double> times;
+	for (std::size_t run = 0; run < calibration_runs; ++run) {
+		std::optional<double> time = time_compile(compiler, compiler_id, source);
+		if (not time) return std::nullopt;
+		times.push_back(*time);
+	}
+
+	std::ranges::nth_element(times, times.begin() + times.size() / 2);
+	return times[times.size() / 2];
+}
+
+/**
+ * @brief Measure the compile times of automatic encodings with a compiler and return them as a calibration table.
+ *
+ * Every encoding compiles a header with an empty resource map, which is the time of parsing the runtime and standard
+ * headers, and a header for each of `calibration_samples`. The time of a sample above that baseline is fitted to a time
+ * per definition plus a time per MiB by least squares. An encoding is limited to the largest file that compiled, and
+ * left out if no sample did. A compiler with the id "MSVC" gets MSVC options, any other gets GCC options.
+ */
+std::string calibrate(std::string_view compiler, std::string_view compiler_id, std::string_view compiler_version) {
+	namespace fs = std::filesystem;
+
+	std::string directory_name = fmt::format("syringe_calibration_{:08x}", std::random_device()());
+	fs::path directory = fs::temp_directory_path() / directory_name;
+	fs::create_directories(directory);
+
+	// Files of a sample are consecutive parts of the random data, so that none of them are duplicates
+	std::size_t data_size = 0;
+	for (auto [count, size] : calibration_samples) data_size = std::max(data_size, count * size);
+	std::vector<std::uint8_t> random_data(data_size);
+	std::mt19937 engine(42);
+	std::uniform_int_distribution<int> distribution(0, 255);
+	for (auto& byte : random_data) byte = static_cast<std::uint8_t>(distribution(engine));
+
+	std::string result = fmt::format(
+		"# Compile times of syringe encodings with {}\n"
+		"# <compiler id> <compiler version> <encoding> <seconds> <seconds per MiB> [<max size>]\n",
+		compiler
+	);
+
+	try {
+		std::vector<std::vector<fs::path>> sample_paths;
+		for (auto [count, size] : calibration_samples) {
+			std::vector<fs::path>& paths = sample_paths.emplace_back();
+			for (std::size_t i = 0; i < count; ++i) {
+				paths.push_back(directory / fmt::format("random_{}_{}.bin", size, i));
+				const char* bytes = reinterpret_cast<const char*>(random_data.data()) + i * size;
+				write_if_changed(paths.back().string(), std::string_view(bytes, size));
+			}
+		}
+
+		for (encoding_t encoding : automatic_encodings) {
+			fs::path source = directory / "resources.cpp";
+			InputConfig config{.variable_name = "resources", .encoding = encoding};
+			syringe(config, source.string(), false);
+			std::optional<double> baseline = median_compile_time(compiler, compiler_id, source);
+			if (not baseline) continue;
+
+			// Sums of the normal equations of seconds = definitions * <seconds> + MiB * <seconds per MiB>
+			double definitions_squared = 0;
+			double definitions_mib = 0;
+			double mib_squared = 0;
+			double definitions_seconds = 0;
+			double mib_seconds = 0;
+			std::size_t max_size = 0;
+
+			for (std::size_t i = 0; i < calibration_samples.size(); ++i) {
+				auto [count, size] = calibration_samples[i];
+				config.paths.clear();
+				for (std::size_t j = 0; j < count; ++j) {
+					config.paths[sample_paths[i][j].string()] = fmt::format("random_{}.bin", j);
+				}
+				syringe(config, source.string(), false);
+
+				std::optional<double> time = median_compile_time(compiler, compiler_id, source);
+				if (not time) break;
+				max_size = std::max(max_size, size);
+
+				double definitions = static_cast<double>(count);
+				double mib = static_cast<double>(count * size) / (1024 * 1024);
+				double seconds = *time - *baseline;
+				definitions_squared += definitions * definitions;
+				definitions_mib += definitions * mib;
+				mib_squared += mib * mib;
+				definitions_seconds += definitions * seconds;
+				mib_seconds += mib * seconds;
+			}
+			if (max_size == 0) continue;
+
+			// With a single sample the time is all per definition, noise can make either part negative
+			encoding_cost_t cost;
+			double determinant = definitions_squared * mib_squared - definitions_mib * definitions_mib;
+			if (determinant > 0) {
+				cost.seconds_per_mib = definitions_squared * mib_seconds - definitions_mib * definitions_seconds;
+				cost.seconds_per_mib = std::max(cost.seconds_per_mib / determinant, 0.0);
+			}
+			cost.seconds = (definitions_seconds - definitions_mib * cost.seconds_per_mib) / definitions_squared;
+			cost.seconds = std::max(cost.seconds, 0.0);
+			if (max_size != calibration_samples.back().size) cost.max_size = max_size;
+			result += format_calibration_row(compiler_id, compiler_version, encoding, cost);
+		}
+	} catch (...) {
+		std::error_code ec;
+		fs::remove_all(directory, ec);
+		throw;
+	}
+
+	fs::remove_all(directory);
+	return result;
 }
 
 void syringe(int argc, const char* const* argv) {
 	auto config = parse_cli(argc, argv);
 
-	if (config.output_path.empty()) {
+	if (not config.runtime_output_path.empty()) {
+		write_if_changed(config.runtime_output_path, runtime_header(config.lite));
+	}
+	if (config.paths.empty() and config.calibrate_compiler.empty()) return;
+
+	if (not config.calibrate_compiler.empty()) {
+		std::string table = calibrate(config.calibrate_compiler, config.compiler_id, config.compiler_version);
+		if (config.output_path.empty()) {
+			std::fwrite(table.data(), 1, table.size(), stdout);
+		} else {
+			write_if_changed(config.output_path, table);
+		}
+		return;
+	}
+
+	// With a data translation unit, the output is its header, which is only replaced if its contents change
+	if (not config.source_path.empty()) {
+		if (config.shards != 0) {
+			syringe_shards(config);
+		} else {
+			syringe_if_changed(config, config.source_path, config.mapped_output);
+		}
+		write_if_changed(config.output_path, declaration_header(config));
+	} else if (config.output_path.empty()) {
 		syringe(config, stdout);
+	} else if (config.if_changed) {
+		syringe_if_changed(config, config.output_path, config.mapped_output);
 	} else {
-		auto file_close = [](FILE* fp) { std::fclose(fp); };
-		std::unique_ptr<FILE, decltype(file_close)> fp(std::fopen(config.output_path.c_str(), "w"), file_close);
-
-		syringe(config, fp.get());
+		syringe(config, config.output_path, config.mapped_output);
 	}
 }
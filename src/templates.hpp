@@ -3,10 +3,28 @@
 
 using namespace fmt::literals;
 
+/// Tag of the resource map constructors, guarded so that both runtimes can be included in one translation unit.
+constexpr std::string_view sorted_unique_tag = R"(#ifndef SYRINGE_SORTED_UNIQUE
+#define SYRINGE_SORTED_UNIQUE
+// Tag for constructing a map from elements that are sorted by key and have unique keys.
+struct sorted_unique_t {
+	explicit sorted_unique_t() = default;
+};
+inline constexpr sorted_unique_t sorted_unique{};
+#endif
+
+)";
+
 constexpr std::string_view cxmap =
 	R"(template<typename Key, typename Value, std::size_t MaxSize, std::strict_weak_order<Key, Key> Compare = std::less<>>
 class cxmap {
 public:
+	constexpr cxmap() = default;
+
+	// Construct a full map from elements that are sorted by key and have unique keys, without sorting them.
+	constexpr cxmap(sorted_unique_t, const std::array<std::pair<Key, Value>, MaxSize>& data) :
+		m_data(data), m_size(MaxSize) {}
+
 	// Element access ==================================================================================================
 	template<typename K>
 	requires std::strict_weak_order<Compare, Key, K>
@@ -153,21 +171,49 @@ private:
 	std::size_t m_size = 0;
 };)";
 
+/// Storage of file contents with word encoding, written after `cxmap`.
+constexpr std::string_view word_bytes = R"(
+
+// File contents packed into little-endian 64-bit words.
+//
+// Access paths:
+// - constexpr: `words`, `operator[]` and `size()` of every `_<sha256>_words` variable;
+// - runtime-only: `span()`, the `_<sha256>` spans and the resource map, because viewing words as bytes needs a
+//   reinterpret_cast, which is not allowed in constant expressions.
+template<std::size_t Size>
+struct word_bytes {
+	static_assert(std::endian::native == std::endian::little, "syringe: word encoding requires a little-endian target");
+
+	std::array<std::uint64_t, (Size + 7) / 8> words;
+
+	constexpr std::uint8_t operator[](std::size_t i) const noexcept {
+		return static_cast<std::uint8_t>(words[i / 8] >> (i % 8 * 8));
+	}
+
+	constexpr std::size_t size() const noexcept {
+		return Size;
+	}
+
+	std::span<const std::uint8_t, Size> span() const noexcept {
+		return std::span<const std::uint8_t, Size>(reinterpret_cast<const std::uint8_t*>(words.data()), Size);
+	}
+};)";
+
 /**
- * @brief Template for a complete resource file.
+ * @brief Template for the runtime of generated headers: the resource map and the helpers of file definitions.
+ *
+ * Generated headers contain the runtime, or include it as a separate header with `--runtime-header`. The include guard
+ * allows several generated headers in one translation unit either way.
  *
  * Format arguments:
- * 0: namespace start, such as "namespace boost {" or "namespace my::nested::namespace {"
- * 1: namespace end, such as "}  // namespace boost"
- * 2: variable name
- * 3: file count
- * 4: all file variable definition strings
- * 5: all file usage strings
- * 6: cxmap string
+ * 0: cxmap string, preceded by `sorted_unique_tag`
+ * 1: helpers string, such as `word_bytes` and `blob_map`
  */
-constexpr auto template_file = FMT_COMPILE(R"(#pragma once
+constexpr auto template_runtime = FMT_COMPILE(R"(#ifndef SYRINGE_RUNTIME_HPP
+#define SYRINGE_RUNTIME_HPP
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
@@ -181,36 +227,624 @@ constexpr auto template_file = FMT_COMPILE(R"(#pragma once
 
 namespace syringe {{
 
-{6}
+{0}{1}
+
+}}  // namespace syringe
+
+#endif  // SYRINGE_RUNTIME_HPP
+)");
+
+/// Resource map of the lite runtime, written after `sorted_unique_tag`.
+constexpr std::string_view lite_cxmap =
+	R"(// Thrown by `lite_cxmap::at` for a missing key, without <stdexcept> for std::out_of_range.
+struct key_not_found {};
+
+// Read-only map from keys to values, with elements sorted by key. Unlike cxmap, it is built on core language features
+// only, so that its header needs no standard headers besides the ones of its key and value types.
+template<typename Key, typename Value, std::size_t Size>
+class lite_cxmap {
+public:
+	struct value_type {
+		Key first;
+		Value second;
+	};
+
+	// Elements of the map, with room for one element so that an empty map is valid
+	struct storage_type {
+		value_type elements[Size == 0 ? 1 : Size];
+	};
+
+	// Construct the map from elements that are sorted by key and have unique keys.
+	constexpr lite_cxmap(sorted_unique_t, const storage_type& data) : m_data(data) {}
+
+	// Element access ==================================================================================================
+	constexpr const Value& at(const Key& k) const {
+		const value_type* it = find(k);
+		if (it != end()) {
+			return it->second;
+		}
+
+		throw key_not_found{};
+	}
+
+	constexpr const Value& operator[](const Key& k) const {
+		return at(k);
+	}
+
+	// Iterators =======================================================================================================
+	constexpr const value_type* begin() const noexcept {
+		return m_data.elements;
+	}
+	constexpr const value_type* cbegin() const noexcept {
+		return m_data.elements;
+	}
+
+	constexpr const value_type* end() const noexcept {
+		return m_data.elements + Size;
+	}
+	constexpr const value_type* cend() const noexcept {
+		return m_data.elements + Size;
+	}
+
+	// Capacity ========================================================================================================
+	constexpr std::size_t size() const noexcept {
+		return Size;
+	}
+	constexpr bool empty() const noexcept {
+		return Size == 0;
+	}
+
+	// Lookup ==========================================================================================================
+	constexpr const value_type* find(const Key& k) const noexcept {
+		std::size_t left = 0;
+		std::size_t right = Size;
+		while (left < right) {
+			std::size_t middle = left + (right - left) / 2;
+			if (m_data.elements[middle].first < k) {
+				left = middle + 1;
+			} else {
+				right = middle;
+			}
+		}
+
+		return left != Size and m_data.elements[left].first == k ? m_data.elements + left : end();
+	}
+
+	constexpr bool contains(const Key& k) const noexcept {
+		return find(k) != end();
+	}
+
+private:
+	storage_type m_data;
+};)";
+
+/**
+ * @brief Template for the lite runtime of generated headers, see `--lite`.
+ *
+ * The lite runtime only includes the headers that the resource map and file definitions need, which saves parsing the
+ * standard library in every translation unit that includes a generated header. It has no word encoding, `#embed` and
+ * blob layout, which need more headers or `std::array`.
+ *
+ * Format arguments:
+ * 0: lite cxmap string, preceded by `sorted_unique_tag`
+ */
+constexpr auto template_lite_runtime = FMT_COMPILE(R"(#ifndef SYRINGE_LITE_RUNTIME_HPP
+#define SYRINGE_LITE_RUNTIME_HPP
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace syringe {{
+
+{0}
+
+}}  // namespace syringe
+
+#endif  // SYRINGE_LITE_RUNTIME_HPP
+)");
+
+/// Include directive for a runtime header at `{0}`, instead of the runtime.
+constexpr auto template_runtime_include = FMT_COMPILE("#include <{0}>\n");
+
+/**
+ * @brief Template for the beginning of a resource file, up to the file variable definitions.
+ *
+ * Format arguments:
+ * 0: runtime, or an include directive for it
+ */
+constexpr auto template_file_begin = FMT_COMPILE(R"(#pragma once
+{0}
+namespace syringe {{
+
+)");
+
+/**
+ * @brief Template for the beginning of the data translation unit of a declaration-only header, up to the file variable
+ * definitions.
+ *
+ * The rest of the translation unit is the same as a resource file, the header declares its resource map.
+ *
+ * Format arguments:
+ * 0: path of the header relative to the translation unit, with forward slashes
+ */
+constexpr auto template_source_begin = FMT_COMPILE(R"(#include "{0}"
+
+namespace syringe {{
+
+)");
 
-{4}
+/**
+ * @brief Template for a declaration-only header, which declares the resource map of a data translation unit.
+ *
+ * The header does not depend on file contents, so translation units that include it are not recompiled when they
+ * change, and it costs about as much to parse as the runtime.
+ *
+ * Format arguments:
+ * 0: runtime, or an include directive for it
+ * 1: namespace start, such as "namespace boost {" or "namespace my::nested::namespace {"
+ * 2: variable name
+ * 3: number of unique paths
+ * 4: map template, "cxmap" or "lite_cxmap"
+ * 5: namespace end, such as "}  // namespace boost"
+ */
+constexpr auto template_declaration_file = FMT_COMPILE(R"(#pragma once
+{0}
+{1}extern const syringe::{4}<std::string_view, std::span<const std::uint8_t>, {3}> {2};{5}
+)");
+
+/**
+ * @brief Template for the beginning of a guard around a file definition, which is skipped if another generated header
+ * in the same translation unit has already defined the file.
+ *
+ * Format arguments:
+ * 0: name of the file definition, see `literal_encoder::symbol`
+ */
+constexpr auto template_file_guard_begin = FMT_COMPILE(R"(#ifndef SYRINGE_FILE_{0}
+#define SYRINGE_FILE_{0}
+)");
+
+/// End of a guard around a file definition.
+constexpr std::string_view template_file_guard_end = "\n#endif";
+
+/**
+ * @brief Template for the part of a resource file between file variable definitions and file usages.
+ *
+ * The resource map is initialized from its elements in key order, which the generator sorts, so that building it at
+ * compile time takes linear time.
+ *
+ * Format arguments:
+ * 0: namespace start, such as "namespace boost {" or "namespace my::nested::namespace {"
+ * 1: variable name
+ * 2: number of unique paths
+ * 3: specifier of the variable, "constexpr" or "const"
+ * 4: map template, "cxmap" or "lite_cxmap"
+ */
+constexpr auto template_file_middle = FMT_COMPILE(R"(
 
 }}  // namespace syringe
 
-{0}constexpr auto {2} = []() {{
-	syringe::cxmap<std::string_view, std::span<const std::uint8_t>, {3}> resources;
+{0}{3} syringe::{4}<std::string_view, std::span<const std::uint8_t>, {2}> {1}{{syringe::sorted_unique, {{{{)");
 
-{5}
+/**
+ * @brief Template for the end of a resource file, after file usages.
+ *
+ * Format arguments:
+ * 0: namespace end, such as "}  // namespace boost"
+ */
+constexpr auto template_file_end = FMT_COMPILE(R"(
+}}}}}};{0}
+)");
 
-	return std::as_const(resources);
-}}();{1}
+/**
+ * @brief Template for the beginning of a file variable definition string, followed by file contents.
+ *
+ * File contents are decimal bytes separated by comma, such as "255,18,52", or wrapped lines of fixed-width cells, such
+ * as "\n\t255, 18, 52,".
+ *
+ * Format arguments:
+ * 0: byte count
+ * 1: file sha256 hex digest (lowercase)
+ */
+constexpr auto template_file_definition_begin = FMT_COMPILE(R"(constexpr std::array<std::uint8_t, {0}> _{1} = {{)");
+
+/// End of a file variable definition string.
+constexpr std::string_view template_file_definition_end = "};";
+
+/// End of a file variable definition string with wrapped file contents.
+constexpr std::string_view template_file_definition_end_wrapped = "\n};";
+
+/**
+ * @brief Template for a file definition with `#embed`, for compilers that support it and can find the file.
+ *
+ * Followed by a fallback definition, which is skipped if the file was embedded.
+ *
+ * Format arguments:
+ * 0: byte count
+ * 1: file sha256 hex digest (lowercase)
+ * 2: absolute path of the file, with forward slashes
+ */
+constexpr auto template_file_embed_definition = FMT_COMPILE(R"(#if defined(__has_embed)
+#if __has_embed("{2}")
+constexpr std::array<std::uint8_t, {0}> _{1} = {{
+#embed "{2}"
+}};
+#define SYRINGE_EMBEDDED_{1}
+#endif
+#endif
 )");
 
 /**
- * @brief Template for a file variable definition string.
+ * @brief Template for the beginning of the fallback file definition with embed encoding, followed by file contents.
+ *
+ * File contents are encoded as for `template_file_definition_begin`.
  *
  * Format arguments:
- * 0: file contents as hex bytes separated by comma, such as "0xff, 0x12, 0x34"
- * 1: byte count
- * 2: file sha256 hex digest (lowercase)
+ * 0: byte count
+ * 1: file sha256 hex digest (lowercase)
  */
-constexpr auto template_file_definition = FMT_COMPILE(R"(constexpr std::array<std::uint8_t, {1}> _{2} = {{{0}}};)");
+constexpr auto template_file_embed_definition_begin = FMT_COMPILE(R"(#ifndef SYRINGE_EMBEDDED_{1}
+constexpr std::array<std::uint8_t, {0}> _{1} = {{)");
 
 /**
- * @brief Template for a file usage string.
+ * @brief Template for the end of a file definition with embed encoding.
+ *
+ * Format arguments:
+ * 0: end of the fallback definition, such as "};"
+ * 1: file sha256 hex digest (lowercase)
+ */
+constexpr auto template_file_embed_definition_end = FMT_COMPILE(R"({0}
+#endif
+#undef SYRINGE_EMBEDDED_{1})");
+
+/**
+ * @brief Template for a file definition with incbin or object encoding.
+ *
+ * The file's contents are defined by an assembly file, see `template_assembly_file`, or by an object file.
+ *
+ * Format arguments:
+ * 0: byte count
+ * 1: file sha256 hex digest (lowercase)
+ */
+constexpr auto template_file_incbin_definition = FMT_COMPILE(R"(extern "C" const std::uint8_t syringe_{1}[];
+constexpr std::span<const std::uint8_t, {0}> _{1}{{syringe_{1}, {0}}};)");
+
+/**
+ * @brief Template for the definition of a file of zero bytes, without its contents.
+ *
+ * The storage is zero-initialized and not const, so compilers place it in `.bss` and it takes no space in the binary.
+ * Contents of such a file can't be read in constant expressions, but its span and the resource map stay constexpr.
+ * The storage is an inline variable with external linkage, so it is a C array with both runtimes: lite and full headers
+ * in different translation units define it with the same type.
+ *
+ * Format arguments:
+ * 0: byte count
+ * 1: file sha256 hex digest (lowercase)
+ */
+constexpr auto template_file_zeros_definition = FMT_COMPILE(R"(inline std::uint8_t _{1}_zeros[{0}]{{}};
+constexpr std::span<const std::uint8_t, {0}> _{1}{{_{1}_zeros}};)");
+
+/**
+ * @brief Template for the beginning of a file definition with word encoding, followed by file contents.
+ *
+ * File contents are word literals separated by commas, see `encode_words`.
+ *
+ * Format arguments:
+ * 0: byte count
+ * 1: file sha256 hex digest (lowercase)
+ */
+constexpr auto template_file_words_definition_begin = FMT_COMPILE(R"(constexpr word_bytes<{0}> _{1}_words{{{{)");
+
+/**
+ * @brief Template for the end of a file definition with word encoding.
+ *
+ * Format arguments:
+ * 0: byte count
+ * 1: file sha256 hex digest (lowercase)
+ */
+constexpr auto template_file_words_definition_end = FMT_COMPILE(R"(}}}};
+const std::span<const std::uint8_t, {0}> _{1} = _{1}_words.span();)");
+
+/**
+ * @brief Template for the beginning of a file definition with string encoding, followed by file contents.
+ *
+ * File contents are string literal chunks on separate lines, such as "\n\t\"abc\\0\"". The array has room for the null
+ * terminator of the string literal, which is excluded from the span defined by `template_file_string_definition_end`.
+ *
+ * With the lite runtime, decimal file contents use this template too, which has no `std::array`.
+ *
+ * Format arguments:
+ * 0: byte count
+ * 1: file sha256 hex digest (lowercase)
+ */
+constexpr auto template_file_string_definition_begin =
+	FMT_COMPILE(R"(constexpr std::uint8_t _{1}_data[{0} + 1] = {{)");
+
+/**
+ * @brief Template for the end of a file definition with string encoding.
+ *
+ * Format arguments:
+ * 0: byte count
+ * 1: file sha256 hex digest (lowercase)
+ */
+constexpr auto template_file_string_definition_end = FMT_COMPILE(R"(
+}};
+constexpr std::span<const std::uint8_t, {0}> _{1}{{_{1}_data, {0}}};)");
+
+/**
+ * @brief Template for a file usage string, an element of the resource map.
  *
  * Format arguments:
  * 0: file identifier (path) such as "resource.txt" or "assets/icons/icon.png"
  * 1: file sha256 hex digest (lowercase)
  */
-constexpr auto template_file_usage = FMT_COMPILE(R"(	resources["{0}"] = syringe::_{1};)");
+constexpr auto template_file_usage = FMT_COMPILE(R"(	{{"{0}", syringe::_{1}}},)");
+
+// Blob layout =========================================================================================================
+// With the blob layout, the contents of all files are stored in one array, and the resource map is an index of offsets
+// into it and into a table of keys. The index has no pointers, so it needs no relocations in position-independent
+// binaries.
+
+/// Number of characters in one row of the key table. A row is one string literal, well below the limits of compilers.
+constexpr std::size_t blob_key_row_size = 2048;
+
+/// Resource map of the blob layout, written after `cxmap`.
+constexpr std::string_view blob_map = R"(
+
+template<typename Offset>
+struct blob_entry {
+	Offset key_offset;
+	Offset key_size;
+	Offset data_offset;
+	Offset data_size;
+};
+
+// Read-only map from paths to file contents, with entries sorted by path. A key at offset `i` is in row
+// `i / sizeof(Keys[0])` of the key table, keys never span two rows.
+template<std::size_t Size, auto& Index, auto& Keys, auto& Blob>
+class blob_map {
+public:
+	using key_type = std::string_view;
+	using mapped_type = std::span<const std::uint8_t>;
+	using value_type = std::pair<key_type, mapped_type>;
+
+	class iterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = blob_map::value_type;
+		using difference_type = std::ptrdiff_t;
+
+		constexpr iterator() = default;
+		constexpr explicit iterator(std::size_t index) : m_index(index) {}
+
+		constexpr value_type operator*() const {
+			return {key(m_index), value(m_index)};
+		}
+
+		constexpr iterator& operator++() {
+			++m_index;
+			return *this;
+		}
+
+		constexpr iterator operator++(int) {
+			auto result = *this;
+			++m_index;
+			return result;
+		}
+
+		constexpr bool operator==(const iterator&) const = default;
+
+	private:
+		std::size_t m_index = 0;
+	};
+
+	// Element access ==================================================================================================
+	constexpr mapped_type at(std::string_view k) const {
+		const auto i = index_of(k);
+		if (i != Size) {
+			return value(i);
+		}
+
+		throw std::out_of_range("blob_map::at: key not found");
+	}
+
+	constexpr mapped_type operator[](std::string_view k) const {
+		return at(k);
+	}
+
+	// Iterators =======================================================================================================
+	constexpr iterator begin() const {
+		return iterator(0);
+	}
+	constexpr iterator cbegin() const {
+		return iterator(0);
+	}
+
+	constexpr iterator end() const {
+		return iterator(Size);
+	}
+	constexpr iterator cend() const {
+		return iterator(Size);
+	}
+
+	// Capacity ========================================================================================================
+	constexpr std::size_t size() const {
+		return Size;
+	}
+	constexpr bool empty() const {
+		return Size == 0;
+	}
+
+	// Lookup ==========================================================================================================
+	constexpr iterator find(std::string_view k) const noexcept {
+		return iterator(index_of(k));
+	}
+
+	constexpr bool contains(std::string_view k) const noexcept {
+		return index_of(k) != Size;
+	}
+
+private:
+	static constexpr std::string_view key(std::size_t i) noexcept {
+		constexpr std::size_t row_size = sizeof(Keys[0]);
+		return {Keys[Index[i].key_offset / row_size] + Index[i].key_offset % row_size, Index[i].key_size};
+	}
+
+	static constexpr mapped_type value(std::size_t i) noexcept {
+		return {Blob + Index[i].data_offset, Index[i].data_size};
+	}
+
+	/// Index of the entry with key `k`, or `Size` if there is none.
+	static constexpr std::size_t index_of(std::string_view k) noexcept {
+		std::size_t left = 0;
+		std::size_t right = Size;
+		while (left < right) {
+			std::size_t middle = left + (right - left) / 2;
+			if (key(middle) < k) {
+				left = middle + 1;
+			} else {
+				right = middle;
+			}
+		}
+
+		return left != Size and key(left) == k ? left : Size;
+	}
+};)";
+
+/**
+ * @brief Template for the beginning of a blob, followed by file contents.
+ *
+ * The blob starts with one zero byte, so that the contents of every file can be preceded by a separator.
+ *
+ * Format arguments:
+ * 0: array name, such as "_resources_blob"
+ * 1: the zero byte, "0" for decimal encoding or "\"\\0\"" for string encoding
+ */
+constexpr auto template_blob_begin = FMT_COMPILE(R"(alignas(64) constexpr std::uint8_t {0}[] = {{{1})");
+
+/// End of the blob.
+constexpr std::string_view template_blob_end = "\n};";
+
+/**
+ * @brief Template for the index of the blob, from the end of the blob to the end of the resource file.
+ *
+ * Format arguments:
+ * 0: namespace start, such as "namespace boost {" or "namespace my::nested::namespace {"
+ * 1: variable name
+ * 2: entry count
+ * 3: rows of the key table, such as "\n\t\"a.txtb.txt\","
+ * 4: row count of the key table (at least 1)
+ * 5: row size of the key table
+ * 6: entries of the index, such as "\n\t{0, 5, 1, 3},"
+ * 7: entry count of the index array (at least 1)
+ * 8: offset type, such as "std::uint32_t"
+ * 9: namespace end, such as "}  // namespace boost"
+ * 10: prefix of the names of the blob, the key table and the index, see `helper_name`, such as "_boost_resources_"
+ */
+constexpr auto template_blob_index = FMT_COMPILE(R"(
+constexpr char {10}keys[{4}][{5}] = {{{3}
+}};
+constexpr blob_entry<{8}> {10}index[{7}] = {{{6}
+}};
+
+}}  // namespace syringe
+
+{0}constexpr syringe::blob_map<{2}, syringe::{10}index, syringe::{10}keys, syringe::{10}blob> {1}{{}};{9}
+)");
+
+// Small file pool =====================================================================================================
+// Small files are stored together in a blob, the pool, instead of in a definition each. Every file is still defined as
+// a span into the pool under its usual name, so usages do not change.
+
+/**
+ * @brief Template for the definition of a file in the small file pool.
+ *
+ * Format arguments:
+ * 0: byte count
+ * 1: file sha256 hex digest (lowercase)
+ * 2: array name of the pool
+ * 3: offset of the file in the pool
+ */
+constexpr auto template_pool_file_definition =
+	FMT_COMPILE(R"(constexpr std::span<const std::uint8_t, {0}> _{1}{{{2} + {3}, {0}}};)");
+
+// Shards ==============================================================================================================
+// With shards, file definitions are split between several translation units, which compile in parallel, and an index
+// translation unit defines the resource map. A declaration of the storage of every file gives its definition external
+// linkage in its shard, and lets the index initialize the map from its address at compile time.
+
+/**
+ * @brief Template for the declaration of the storage of a file that is defined as an array.
+ *
+ * Format arguments:
+ * 0: byte count
+ * 1: file sha256 hex digest (lowercase)
+ */
+constexpr auto template_shard_array_declaration = FMT_COMPILE(R"(extern const std::array<std::uint8_t, {0}> _{1};)");
+
+/// Template for the declaration of the storage of a file with string encoding, see `template_shard_array_declaration`.
+constexpr auto template_shard_data_declaration = FMT_COMPILE(R"(extern const std::uint8_t _{1}_data[{0} + 1];)");
+
+/**
+ * @brief Template for the span of a file with string encoding in the index, after the declaration of its storage.
+ *
+ * Format arguments:
+ * 0: byte count
+ * 1: file sha256 hex digest (lowercase)
+ */
+constexpr auto template_shard_data_span =
+	FMT_COMPILE(R"(constexpr std::span<const std::uint8_t, {0}> _{1}{{_{1}_data, {0}}};)");
+
+/// End of a shard, after the file definitions.
+constexpr std::string_view template_shard_end = R"(
+
+}  // namespace syringe
+)";
+
+// Assembly file =======================================================================================================
+// With incbin encoding, file contents are included by the assembler into an assembly file that is compiled alongside
+// the header. The file is preprocessed (".S") to select directives for ELF, Mach-O and COFF targets.
+
+/// Beginning of an assembly file.
+constexpr auto template_assembly_begin = FMT_COMPILE(R"(/* Generated by syringe. Assemble with the C preprocessor. */
+#if defined(__APPLE__) || (defined(_WIN32) && !defined(_WIN64))
+#define SYRINGE_SYMBOL(name) _##name
+#else
+#define SYRINGE_SYMBOL(name) name
+#endif
+)");
+
+/**
+ * @brief Template for the definition of one file in an assembly file.
+ *
+ * Every file is placed in its own section, which is a COMDAT group where supported, so that a file included by several
+ * assembly files is only linked once.
+ *
+ * Format arguments:
+ * 0: file sha256 hex digest (lowercase)
+ * 1: byte count
+ * 2: absolute path of the file, escaped for an assembler string
+ */
+constexpr auto template_assembly_file = FMT_COMPILE(R"(
+#if defined(__ELF__)
+	.section .rodata.syringe_{0},"aG",%progbits,syringe_{0},comdat
+	.type syringe_{0}, %object
+	.size syringe_{0}, {1}
+#elif defined(__APPLE__)
+	.const_data
+#elif defined(_WIN32)
+	.section .rdata$syringe_{0},"dr"
+	.linkonce discard
+#endif
+	.balign 64
+	.globl SYRINGE_SYMBOL(syringe_{0})
+SYRINGE_SYMBOL(syringe_{0}):
+	.incbin "{2}"
+)");
+
+/// End of an assembly file.
+constexpr std::string_view template_assembly_end = R"(
+#if defined(__ELF__)
+	.section .note.GNU-stack,"",%progbits
+#endif
+)";
@@ -0,0 +1,284 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define SYRINGE_IO_URING 1
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <linux/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#define SYRINGE_IO_URING 0
+#endif
+
+/// Files up to this size are read by the batched reader, larger files are mapped individually.
+constexpr std::size_t batch_read_limit = 64 * 1024;
+
+/// Contents of small regular files read in one batch. Files that were not read have no value.
+struct file_batch_t {
+	std::vector<std::vector<std::uint8_t>> buffers;
+	std::vector<std::optional<std::span<const std::uint8_t>>> contents;
+};
+
+#if SYRINGE_IO_URING
+/**
+ * @brief Minimal io_uring submission and completion queue, driven by raw system calls.
+ *
+ * Only what the batched reader needs is implemented: filling submission entries, submitting them all at once and
+ * waiting for their completions.
+ */
+class io_uring_queue {
+public:
+	/// Create a queue, or return nullptr if io_uring is not available (old kernel, disabled by seccomp or sysctl).
+	static std::unique_ptr<io_uring_queue> create(unsigned entries) {
+		io_uring_params params{};
+		int fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+		if (fd < 0) return nullptr;
+
+		std::unique_ptr<io_uring_queue> result(new io_uring_queue(fd, params));
+		if (not result->m_sqes) return nullptr;
+		return result;
+	}
+
+	io_uring_queue(const io_uring_queue&) = delete;
+	io_uring_queue& operator=(const io_uring_queue&) = delete;
+
+	~io_uring_queue() {
+		if (m_sqes != nullptr) ::munmap(m_sqes, m_sqes_size);
+		if (m_cq_ring != nullptr and m_cq_ring != m_sq_ring) ::munmap(m_cq_ring, m_cq_ring_size);
+		if (m_sq_ring != nullptr) ::munmap(m_sq_ring, m_sq_ring_size);
+		::close(m_fd);
+	}
+
+	unsigned capacity() const noexcept {
+		return m_sq_entries;
+	}
+
+	/// Get a zeroed submission entry. Callers must not request more than `capacity()` entries per `submit_and_wait`.
+	io_uring_sqe& next_sqe() noexcept {
+		unsigned index = m_sq_local_tail++ & *m_sq_mask;
+		io_uring_sqe& sqe = m_sqes[index];
+		std::memset(&sqe, 0, sizeof(sqe));
+		m_sq_array[index] = index;
+		return sqe;
+	}
+
+	/// Submit all pending entries, wait until they complete and call `callback(user_data, result)` for each of them.
+	template<typename F>
+	void submit_and_wait(F&& callback) {
+		unsigned pending = m_sq_local_tail - std::atomic_ref(*m_sq_tail).load(std::memory_order_relaxed);
+		std::atomic_ref(*m_sq_tail).store(m_sq_local_tail, std::memory_order_release);
+
+		unsigned completed = 0;
+		while (completed < pending) {
+			unsigned to_submit = m_sq_local_tail - std::atomic_ref(*m_sq_head).load(std::memory_order_acquire);
+			long result = ::syscall(
+				__NR_io_uring_enter, m_fd, to_submit, pending - completed, IORING_ENTER_GETEVENTS, nullptr, 0
+			);
+			if (result < 0 and errno != EINTR and errno != EAGAIN and errno != EBUSY) {
+				throw std::system_error(errno, std::system_category(), "io_uring_enter");
+			}
+
+			unsigned head = *m_cq_head;
+			unsigned tail = std::atomic_ref(*m_cq_tail).load(std::memory_order_acquire);
+			for (; head != tail; ++head, ++completed) {
+				const io_uring_cqe& cqe = m_cqes[head & *m_cq_mask];
+				callback(cqe.user_data, cqe.res);
+			}
+			std::atomic_ref(*m_cq_head).store(head, std::memory_order_release);
+		}
+	}
+
+private:
+	io_uring_queue(int fd, const io_uring_params& params) : m_fd(fd), m_sq_entries(params.sq_entries) {
+		m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(std::uint32_t);
+		m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+
+		bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+		if (single_mmap) m_sq_ring_size = m_cq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+
+		m_sq_ring = map(m_sq_ring_size, IORING_OFF_SQ_RING);
+		if (m_sq_ring == nullptr) return;
+		m_cq_ring = single_mmap ? m_sq_ring : map(m_cq_ring_size, IORING_OFF_CQ_RING);
+		if (m_cq_ring == nullptr) return;
+		void* sqes = map(m_sqes_size, IORING_OFF_SQES);
+		if (sqes == nullptr) return;
+
+		auto* sq = static_cast<char*>(m_sq_ring);
+		auto* cq = static_cast<char*>(m_cq_ring);
+		m_sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+		m_sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+		m_sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+		m_sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+		m_cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+		m_cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+		m_cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+		m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+		m_sq_local_tail = *m_sq_tail;
+		m_sqes = static_cast<io_uring_sqe*>(sqes);
+	}
+
+	void* map(std::size_t size, off_t offset) const noexcept {
+		void* result = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, offset);
+		return result == MAP_FAILED ? nullptr : result;
+	}
+
+	int m_fd;
+	unsigned m_sq_entries;
+
+	void* m_sq_ring = nullptr;
+	void* m_cq_ring = nullptr;
+	std::size_t m_sq_ring_size = 0;
+	std::size_t m_cq_ring_size = 0;
+	std::size_t m_sqes_size = 0;
+
+	unsigned* m_sq_head = nullptr;
+	unsigned* m_sq_tail = nullptr;
+	unsigned* m_sq_mask = nullptr;
+	unsigned* m_sq_array = nullptr;
+	unsigned* m_cq_head = nullptr;
+	unsigned* m_cq_tail = nullptr;
+	unsigned* m_cq_mask = nullptr;
+	io_uring_cqe* m_cqes = nullptr;
+	io_uring_sqe* m_sqes = nullptr;
+	unsigned m_sq_local_tail = 0;
+};
+#endif  // SYRINGE_IO_URING
+
+/**
+ * @brief Read small regular files with batched asynchronous I/O.
+ *
+ * On Linux with io_uring, the files are stat'ed with one system call per batch, then only the small regular files are
+ * opened with a second one, and read and closed with a third one. Other files are never opened here, so that opening
+ * them has no side effects, such as a FIFO losing its writer. Files that are not regular, larger than
+ * `batch_read_limit`, with contents of another size than stat reports, or failed for any reason are left without a
+ * value and should be read synchronously. On other
+ * systems, or if the kernel does not support io_uring, no file is read.
+ */
+file_batch_t read_small_files(std::span<const std::string* const> paths) {
+	file_batch_t result;
+	result.contents.resize(paths.size());
+
+#if SYRINGE_IO_URING
+	static std::atomic<bool> unsupported = false;
+	if (unsupported.load(std::memory_order_relaxed) or paths.empty()) return result;
+
+	thread_local std::unique_ptr<io_uring_queue> queue = io_uring_queue::create(256);
+	if (queue == nullptr) {
+		unsupported.store(true, std::memory_order_relaxed);
+		return result;
+	}
+
+	// Every file needs two submission entries in each round
+	const std::size_t batch_size = queue->capacity() / 2;
+
+	std::vector<int> fds(paths.size(), -1);
+	std::vector<struct statx> stats(paths.size());
+	std::vector<bool> small(paths.size(), false);
+
+	for (std::size_t first = 0; first < paths.size(); first += batch_size) {
+		std::size_t last = std::min(paths.size(), first + batch_size);
+
+		// Stat every file. User data is twice the index, plus one for the second operation of a file in a round.
+		for (std::size_t i = first; i < last; ++i) {
+			io_uring_sqe& statx_sqe = queue->next_sqe();
+			statx_sqe.opcode = IORING_OP_STATX;
+			statx_sqe.fd = AT_FDCWD;
+			statx_sqe.addr = reinterpret_cast<std::uintptr_t>(paths[i]->c_str());
+			statx_sqe.len = STATX_TYPE | STATX_SIZE;
+			statx_sqe.off = reinterpret_cast<std::uintptr_t>(&stats[i]);
+			statx_sqe.user_data = 2 * i + 1;
+		}
+
+		bool opcode_unsupported = false;
+		queue->submit_and_wait([&](std::uint64_t user_data, int res) {
+			std::size_t i = user_data / 2;
+			small[i] = res == 0 and S_ISREG(stats[i].stx_mode) and stats[i].stx_size <= batch_read_limit;
+			opcode_unsupported |= res == -EINVAL;
+		});
+
+		// Open small regular files only. O_NONBLOCK keeps a file that was replaced by a FIFO from blocking the batch.
+		for (std::size_t i = first; i < last and not opcode_unsupported; ++i) {
+			if (not small[i]) continue;
+
+			io_uring_sqe& open_sqe = queue->next_sqe();
+			open_sqe.opcode = IORING_OP_OPENAT;
+			open_sqe.fd = AT_FDCWD;
+			open_sqe.addr = reinterpret_cast<std::uintptr_t>(paths[i]->c_str());
+			open_sqe.open_flags = O_RDONLY | O_CLOEXEC | O_NONBLOCK;
+			open_sqe.user_data = 2 * i;
+		}
+
+		queue->submit_and_wait([&](std::uint64_t user_data, int res) {
+			fds[user_data / 2] = res;
+			opcode_unsupported |= res == -EINVAL;
+		});
+
+		// Lay out every small regular file in one buffer, with room for one more byte than its size. Pseudo-files, such
+		// as the ones in /proc, can have more contents than their size, which is often 0.
+		std::size_t buffer_size = 0;
+		for (std::size_t i = first; i < last; ++i) {
+			if (fds[i] >= 0 and small[i]) buffer_size += stats[i].stx_size + 1;
+		}
+		auto& buffer = result.buffers.emplace_back(buffer_size);
+
+		// Read small files and close every opened file. Closing is hard-linked, so it also runs after a failed read.
+		std::size_t offset = 0;
+		for (std::size_t i = first; i < last; ++i) {
+			if (fds[i] < 0) continue;
+
+			std::size_t size = stats[i].stx_size;
+			if (small[i]) {
+				io_uring_sqe& read_sqe = queue->next_sqe();
+				read_sqe.opcode = IORING_OP_READ;
+				read_sqe.fd = fds[i];
+				read_sqe.addr = reinterpret_cast<std::uintptr_t>(buffer.data() + offset);
+				read_sqe.len = static_cast<std::uint32_t>(size + 1);
+				read_sqe.off = 0;
+				read_sqe.flags = IOSQE_IO_HARDLINK;
+				read_sqe.user_data = 2 * i;
+
+				result.contents[i].emplace(buffer.data() + offset, size);
+				offset += size + 1;
+			}
+
+			io_uring_sqe& close_sqe = queue->next_sqe();
+			close_sqe.opcode = IORING_OP_CLOSE;
+			close_sqe.fd = fds[i];
+			close_sqe.user_data = 2 * i + 1;
+		}
+
+		queue->submit_and_wait([&](std::uint64_t user_data, int res) {
+			std::size_t i = user_data / 2;
+
+			// A read of any other size than the stat'ed one means that the file changed since, or is a pseudo-file with
+			// contents of unknown size. Leave it to the synchronous reader.
+			if (user_data % 2 == 0 and static_cast<std::int64_t>(res) != static_cast<std::int64_t>(stats[i].stx_size)) {
+				result.contents[i].reset();
+			}
+		});
+
+		// Kernels before 5.6 have io_uring, but not the operations used here
+		if (opcode_unsupported) {
+			unsupported.store(true, std::memory_order_relaxed);
+			break;
+		}
+	}
+#endif  // SYRINGE_IO_URING
+
+	return result;
+}
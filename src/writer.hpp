@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Output writers ======================================================================================================
+// Writers receive the generated header piece by piece, so that the complete output never has to be held in memory.
+// Every writer provides a `write(std::string_view)` member function.
+
+template<typename T>
+concept output_writer = requires(T& writer, std::string_view text) { writer.write(text); };
+
+/// Writer into a C stream through a fixed-size buffer.
+class file_writer {
+public:
+	static constexpr std::size_t buffer_size = 1024 * 1024;
+
+	explicit file_writer(FILE* fp) : m_fp(fp) {
+		m_buffer.reserve(buffer_size);
+	}
+
+	file_writer(const file_writer&) = delete;
+	file_writer& operator=(const file_writer&) = delete;
+
+	~file_writer() {
+		try {
+			flush();
+		} catch (...) {
+			// Errors while unwinding are reported by the original exception
+		}
+	}
+
+	void write(std::string_view text) {
+		if (m_buffer.size() + text.size() > buffer_size) flush();
+
+		if (text.size() >= buffer_size) {
+			write_through(text);
+		} else {
+			m_buffer.insert(m_buffer.end(), text.begin(), text.end());
+		}
+	}
+
+	void flush() {
+		write_through({m_buffer.data(), m_buffer.size()});
+		m_buffer.clear();
+
+		if (std::fflush(m_fp) != 0) throw std::runtime_error("could not write output");
+	}
+
+private:
+	void write_through(std::string_view text) {
+		if (std::fwrite(text.data(), 1, text.size(), m_fp) != text.size()) {
+			throw std::runtime_error("could not write output");
+		}
+	}
+
+	FILE* m_fp;
+	std::vector<char> m_buffer;
+};
+
+/// Writer that appends to a string.
+class string_writer {
+public:
+	explicit string_writer(std::string& out) : m_out(out) {}
+
+	void write(std::string_view text) {
+		m_out += text;
+	}
+
+private:
+	std::string& m_out;
+};
@@ -1,7 +1,42 @@
 cmake_minimum_required(VERSION 3.15.0)
 
+# Processor that object files are written for, or an empty string if the target can't link them. Object files are
+# ELF-64 for x86_64 or aarch64, which the executable format that CMake detected from the C++ compiler has to match.
+function(_syringe_object_machine OUTPUT)
+	string(TOLOWER "${CMAKE_SYSTEM_PROCESSOR}" PROCESSOR)
+	if(CMAKE_EXECUTABLE_FORMAT STREQUAL "ELF" AND CMAKE_SIZEOF_VOID_P EQUAL 8
+		AND PROCESSOR MATCHES "^(x86_64|amd64|aarch64|arm64)$")
+		set(${OUTPUT} "${PROCESSOR}" PARENT_SCOPE)
+	else()
+		set(${OUTPUT} "" PARENT_SCOPE)
+	endif()
+endfunction()
+
+# Encoding of the file that defines contents outside of the header: ENCODING itself, or with EXTERNAL_ABOVE, incbin if
+# the project enabled ASM, and object otherwise. Empty if EXTERNAL_ABOVE has neither, because the target can't link
+# object files.
+function(_syringe_external_encoding OUTPUT ENCODING EXTERNAL_ABOVE)
+	if(NOT EXTERNAL_ABOVE)
+		set(${OUTPUT} "${ENCODING}" PARENT_SCOPE)
+	elseif(CMAKE_ASM_COMPILER_LOADED)
+		set(${OUTPUT} "incbin" PARENT_SCOPE)
+	else()
+		_syringe_object_machine(MACHINE)
+		if(MACHINE)
+			set(${OUTPUT} "object" PARENT_SCOPE)
+		else()
+			set(${OUTPUT} "" PARENT_SCOPE)
+		endif()
+	endif()
+endfunction()
+
 function(inject_files)
-	cmake_parse_arguments(INJECT "" "VARIABLE;PREFIX;RELATIVE;OUTPUT" "FILES" ${ARGN})
+	cmake_parse_arguments(INJECT
+		"BLOB;LITE;SOURCE"
+		"VARIABLE;PREFIX;RELATIVE;OUTPUT;ENCODING;POOL_BELOW;EXTERNAL_ABOVE;CALIBRATION;RUNTIME;SHARDS"
+		"FILES"
+		${ARGN}
+	)
 
 	find_program(SYRINGE_EXECUTABLE syringe REQUIRED)
 
@@ -41,38 +76,242 @@ function(inject_files)
 		set(INJECT_VARIABLE_ARGS --variable "${INJECT_VARIABLE}")
 	endif()
 
+	if(INJECT_ENCODING)
+		set(INJECT_ENCODING_ARGS --encoding "${INJECT_ENCODING}")
+	endif()
+
+	# Automatic encoding picks encodings for the compiler of the project, by a table from syringe_calibrate if given
+	if(INJECT_ENCODING STREQUAL "auto")
+		set(INJECT_COMPILER_ARGS
+			--compiler-id "${CMAKE_CXX_COMPILER_ID}"
+			--compiler-version "${CMAKE_CXX_COMPILER_VERSION}"
+		)
+	endif()
+
+	if(INJECT_CALIBRATION)
+		file(REAL_PATH "${INJECT_CALIBRATION}" INJECT_CALIBRATION BASE_DIRECTORY "${CMAKE_CURRENT_BINARY_DIR}")
+		set(INJECT_CALIBRATION_ARGS --calibration "${INJECT_CALIBRATION}")
+	endif()
+
+	if(INJECT_BLOB)
+		set(INJECT_BLOB_ARGS --blob)
+	endif()
+
+	# The lite runtime only includes <cstddef>, <cstdint>, <span> and <string_view>, for headers included by many TUs
+	if(INJECT_LITE)
+		set(INJECT_LITE_ARGS --lite)
+	endif()
+
+	# The runtime is included from a separate header, such as the one of syringe_add_runtime
+	if(INJECT_RUNTIME)
+		set(INJECT_RUNTIME_ARGS --runtime-header "${INJECT_RUNTIME}")
+	endif()
+
+	if(INJECT_POOL_BELOW)
+		set(INJECT_POOL_ARGS --pool-below "${INJECT_POOL_BELOW}")
+	endif()
+
+	# With incbin and object encodings, file contents are in a .S or .o file next to the header. Files above
+	# EXTERNAL_ABOVE bytes go to one of them, see _syringe_external_encoding.
+	_syringe_external_encoding(INJECT_EXTERNAL "${INJECT_ENCODING}" "${INJECT_EXTERNAL_ABOVE}")
+	if(INJECT_EXTERNAL_ABOVE)
+		set(INJECT_EXTERNAL_ABOVE_ARGS --external-above "${INJECT_EXTERNAL_ABOVE}")
+		if(NOT INJECT_EXTERNAL)
+			message(SEND_ERROR
+				"inject_files: EXTERNAL_ABOVE requires enable_language(ASM) in the project, because this target can't "
+				"link ELF objects (${CMAKE_EXECUTABLE_FORMAT} on ${CMAKE_SYSTEM_PROCESSOR}). Enable ASM, or choose an "
+				"ENCODING instead of EXTERNAL_ABOVE."
+			)
+		endif()
+	endif()
+
+	get_filename_component(INJECT_OUTPUT_NAME "${INJECT_OUTPUT}" NAME_WE)
+	if(INJECT_EXTERNAL STREQUAL "incbin")
+		set(INJECT_EXTERNAL_OUTPUT "${INJECT_OUTPUT_DIR}/${INJECT_OUTPUT_NAME}.S")
+		set(INJECT_EXTERNAL_ARGS --assembly-output "${INJECT_EXTERNAL_OUTPUT}")
+	elseif(INJECT_EXTERNAL STREQUAL "object")
+		_syringe_object_machine(INJECT_OBJECT_MACHINE)
+		if(NOT INJECT_OBJECT_MACHINE)
+			message(SEND_ERROR
+				"inject_files: ENCODING object requires a 64-bit ELF target on x86_64 or aarch64, this target is "
+				"${CMAKE_EXECUTABLE_FORMAT} on ${CMAKE_SYSTEM_PROCESSOR}"
+			)
+		endif()
+
+		set(INJECT_EXTERNAL_OUTPUT "${INJECT_OUTPUT_DIR}/${INJECT_OUTPUT_NAME}.o")
+		set(INJECT_EXTERNAL_ARGS
+			--object-output "${INJECT_EXTERNAL_OUTPUT}"
+			--object-machine "${INJECT_OBJECT_MACHINE}"
+		)
+	endif()
+
+	# With SOURCE, file contents are in a .cpp file next to the header, which only declares the resource map. With
+	# SHARDS, that file is an index, and file contents are split between <name>_0.cpp to <name>_<SHARDS - 1>.cpp.
+	if(INJECT_SOURCE OR INJECT_SHARDS)
+		# The map of word encoding is initialized at runtime, static initializers of other files could see it empty
+		if(INJECT_ENCODING STREQUAL "words")
+			message(SEND_ERROR "inject_files: ENCODING words can't be combined with SOURCE or SHARDS")
+		endif()
+
+		set(INJECT_SOURCE_OUTPUT "${INJECT_OUTPUT_DIR}/${INJECT_OUTPUT_NAME}.cpp")
+		set(INJECT_SOURCE_ARGS --source-output "${INJECT_SOURCE_OUTPUT}")
+	endif()
+
+	if(INJECT_SHARDS)
+		list(APPEND INJECT_SOURCE_ARGS --shards "${INJECT_SHARDS}")
+		math(EXPR INJECT_LAST_SHARD "${INJECT_SHARDS} - 1")
+		foreach(INJECT_SHARD RANGE ${INJECT_LAST_SHARD})
+			list(APPEND INJECT_SOURCE_OUTPUT "${INJECT_OUTPUT_DIR}/${INJECT_OUTPUT_NAME}_${INJECT_SHARD}.cpp")
+		endforeach()
+	endif()
+
 	# Create command ---------------------------------------------------------------------------------------------------
+	# The output is only replaced when its contents change. Ninja restats outputs of custom commands, so targets that
+	# include an unchanged header are not recompiled.
 	add_custom_command(
-		OUTPUT "${INJECT_OUTPUT}"
-		DEPENDS ${INJECT_FILES}
+		OUTPUT "${INJECT_OUTPUT}" ${INJECT_SOURCE_OUTPUT} ${INJECT_EXTERNAL_OUTPUT}
+		DEPENDS ${INJECT_FILES} ${INJECT_CALIBRATION}
 		COMMAND "${CMAKE_COMMAND}" -E make_directory "${INJECT_OUTPUT_DIR}"
 		COMMAND "${SYRINGE_EXECUTABLE}"
 			${INJECT_FILES}
 			${INJECT_RELATIVE_ARGS}
 			${INJECT_PREFIX_ARGS}
 			${INJECT_VARIABLE_ARGS}
-			> "${INJECT_OUTPUT}"
+			${INJECT_ENCODING_ARGS}
+			${INJECT_COMPILER_ARGS}
+			${INJECT_CALIBRATION_ARGS}
+			${INJECT_BLOB_ARGS}
+			${INJECT_POOL_ARGS}
+			${INJECT_EXTERNAL_ABOVE_ARGS}
+			${INJECT_EXTERNAL_ARGS}
+			${INJECT_LITE_ARGS}
+			${INJECT_RUNTIME_ARGS}
+			${INJECT_SOURCE_ARGS}
+			--output "${INJECT_OUTPUT}"
+			--if-changed
 		COMMENT "Injecting files into ${INJECT_OUTPUT}"
 		VERBATIM
 	)
 endfunction()
 
 function(target_inject_files TARGET)
-	cmake_parse_arguments(INJECT "" "VARIABLE;PREFIX;RELATIVE;OUTPUT" "FILES" ${ARGN})
+	cmake_parse_arguments(INJECT
+		"BLOB;LITE;SOURCE"
+		"VARIABLE;PREFIX;RELATIVE;OUTPUT;ENCODING;POOL_BELOW;EXTERNAL_ABOVE;CALIBRATION;SHARDS"
+		"FILES"
+		${ARGN}
+	)
 
 	set(BASE_DIR "${CMAKE_CURRENT_BINARY_DIR}/syringe_include/${TARGET}")
 	if(IS_ABSOLUTE ${INJECT_OUTPUT})
 		message(SEND_ERROR "target_inject_files: OUTPUT cannot be an absolute path - header path is appended to ${BASE_DIR}")
 	endif()
 
+	if(INJECT_BLOB)
+		set(INJECT_BLOB_ARG BLOB)
+	endif()
+
+	if(INJECT_SOURCE)
+		set(INJECT_SOURCE_ARG SOURCE)
+	endif()
+
+	# Generated headers of all targets share the runtime header, except with LITE, where the small lite runtime is
+	# written into the header instead. The target is not linked to syringe::runtime, because that would fix the
+	# signature of target_link_libraries for the project.
+	if(INJECT_LITE)
+		set(INJECT_LITE_ARG LITE)
+	else()
+		set(INJECT_RUNTIME "syringe/runtime.hpp")
+		syringe_add_runtime()
+		add_dependencies(${TARGET} syringe_runtime_header)
+		target_include_directories(${TARGET} PRIVATE "$<TARGET_PROPERTY:syringe_runtime,INTERFACE_INCLUDE_DIRECTORIES>")
+	endif()
+
 	inject_files(
 		FILES ${INJECT_FILES}
 		OUTPUT "${BASE_DIR}/${INJECT_OUTPUT}"
 		VARIABLE "${INJECT_VARIABLE}"
 		RELATIVE "${INJECT_RELATIVE}"
 		PREFIX "${INJECT_PREFIX}"
+		ENCODING "${INJECT_ENCODING}"
+		POOL_BELOW "${INJECT_POOL_BELOW}"
+		EXTERNAL_ABOVE "${INJECT_EXTERNAL_ABOVE}"
+		CALIBRATION "${INJECT_CALIBRATION}"
+		RUNTIME "${INJECT_RUNTIME}"
+		SHARDS "${INJECT_SHARDS}"
+		${INJECT_BLOB_ARG}
+		${INJECT_LITE_ARG}
+		${INJECT_SOURCE_ARG}
 	)
 
 	target_include_directories(${TARGET} PRIVATE "${BASE_DIR}")
 	target_sources(${TARGET} PRIVATE "${BASE_DIR}/${INJECT_OUTPUT}")
+
+	get_filename_component(INJECT_OUTPUT_NAME "${BASE_DIR}/${INJECT_OUTPUT}" NAME_WE)
+	get_filename_component(INJECT_OUTPUT_DIR "${BASE_DIR}/${INJECT_OUTPUT}" DIRECTORY)
+	if(INJECT_SOURCE OR INJECT_SHARDS)
+		target_sources(${TARGET} PRIVATE "${INJECT_OUTPUT_DIR}/${INJECT_OUTPUT_NAME}.cpp")
+	endif()
+	if(INJECT_SHARDS)
+		math(EXPR INJECT_LAST_SHARD "${INJECT_SHARDS} - 1")
+		foreach(INJECT_SHARD RANGE ${INJECT_LAST_SHARD})
+			target_sources(${TARGET} PRIVATE "${INJECT_OUTPUT_DIR}/${INJECT_OUTPUT_NAME}_${INJECT_SHARD}.cpp")
+		endforeach()
+	endif()
+
+	_syringe_external_encoding(INJECT_EXTERNAL "${INJECT_ENCODING}" "${INJECT_EXTERNAL_ABOVE}")
+
+	if(INJECT_EXTERNAL STREQUAL "incbin")
+		# enable_language can not be called from a function, so the project has to enable ASM itself
+		if(NOT CMAKE_ASM_COMPILER_LOADED)
+			message(SEND_ERROR "target_inject_files: ENCODING incbin requires enable_language(ASM) in the project")
+		endif()
+
+		target_sources(${TARGET} PRIVATE "${INJECT_OUTPUT_DIR}/${INJECT_OUTPUT_NAME}.S")
+	elseif(INJECT_EXTERNAL STREQUAL "object")
+		target_sources(${TARGET} PRIVATE "${INJECT_OUTPUT_DIR}/${INJECT_OUTPUT_NAME}.o")
+	endif()
+endfunction()
+
+# Create the interface target syringe::runtime, once. It provides the runtime header <syringe/runtime.hpp>, with the
+# resource map that generated headers include when given RUNTIME. The header can be precompiled.
+function(syringe_add_runtime)
+	if(TARGET syringe_runtime)
+		return()
+	endif()
+
+	find_program(SYRINGE_EXECUTABLE syringe REQUIRED)
+	set(SYRINGE_RUNTIME_DIR "${CMAKE_BINARY_DIR}/syringe_runtime")
+
+	add_custom_command(
+		OUTPUT "${SYRINGE_RUNTIME_DIR}/syringe/runtime.hpp"
+		COMMAND "${CMAKE_COMMAND}" -E make_directory "${SYRINGE_RUNTIME_DIR}/syringe"
+		COMMAND "${SYRINGE_EXECUTABLE}" --runtime-output "${SYRINGE_RUNTIME_DIR}/syringe/runtime.hpp"
+		COMMENT "Writing the syringe runtime header"
+		VERBATIM
+	)
+	add_custom_target(syringe_runtime_header DEPENDS "${SYRINGE_RUNTIME_DIR}/syringe/runtime.hpp")
+
+	add_library(syringe_runtime INTERFACE)
+	add_library(syringe::runtime ALIAS syringe_runtime)
+	target_include_directories(syringe_runtime INTERFACE "${SYRINGE_RUNTIME_DIR}")
+	add_dependencies(syringe_runtime syringe_runtime_header)
+endfunction()
+
+# Measure compile times of encodings with the C++ compiler of the project, for CALIBRATION with ENCODING auto. The
+# table is measured at build time, once, because a calibration run compiles several large headers.
+function(syringe_calibrate OUTPUT)
+	find_program(SYRINGE_EXECUTABLE syringe REQUIRED)
+	file(REAL_PATH "${OUTPUT}" OUTPUT BASE_DIRECTORY "${CMAKE_CURRENT_BINARY_DIR}")
+
+	add_custom_command(
+		OUTPUT "${OUTPUT}"
+		COMMAND "${SYRINGE_EXECUTABLE}"
+			--calibrate "${CMAKE_CXX_COMPILER}"
+			--compiler-id "${CMAKE_CXX_COMPILER_ID}"
+			--compiler-version "${CMAKE_CXX_COMPILER_VERSION}"
+			--output "${OUTPUT}"
+		COMMENT "Calibrating syringe encodings for ${CMAKE_CXX_COMPILER_ID} ${CMAKE_CXX_COMPILER_VERSION}"
+		VERBATIM
+	)
 endfunction()
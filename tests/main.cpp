@@ -1,12 +1,28 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "doctest.h"
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <numeric>
+#include <random>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <vector>
 
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
 #include "deps/ctre-unicode.hpp"
+#include "calibration.hpp"
+#include "encode.hpp"
 #include "syringe.hpp"
 #include "util.hpp"
 
@@ -15,7 +31,8 @@ using namespace std;
 auto match_definition = ctre::match<R"#(constexpr std::array<std::uint8_t, (\d+)> _(\w+) = \{((?:\d+,)*\d+)\};)#">;
 auto match_definition_empty = ctre::match<R"#(constexpr std::array<std::uint8_t, (\d+)> _(\w+) = \{\};)#">;
 auto match_definition_until_data = ctre::starts_with<R"#(constexpr std::array<std::uint8_t, (\d+)> _(\w+) = \{)#">;
-auto match_usage = ctre::match<R"#(\tresources\["((?:[^"\\]|\\.)*)"\] = syringe::_(\w+);)#">;
+auto match_zeros_definition = ctre::match<R"#(inline std::uint8_t _(\w+)_zeros\[(\d+)\]\{\};)#">;
+auto match_usage = ctre::match<R"#(\t\{"((?:[^"\\]|\\.)*)", syringe::_(\w+)\},)#">;
 
 TEST_CASE("Inject abc.txt") {
 	string inject_file = syringe({
@@ -110,24 +127,27 @@ TEST_CASE("Inject 1MiB_null.bin") {
 	bool definition_found = false;
 	bool usage_found = false;
 
+	// Zero bytes are not written out, the file is zero-initialized storage
 	size_t i = 0;
 	for (; i < lines.size(); ++i) {
-		string_view line = lines[i];
-		auto [match, size, digest] = match_definition_until_data(line);  // CTRE crashes on full match lol
+		auto [match, digest, size] = match_zeros_definition(lines[i]);
 		if (match) {
 			definition_found = true;
 
 			CHECK(size == "1048576");
 			CHECK(digest == "30e14955ebf1352266dc2ff8067e68104607e750abb9d3b36582b8af909fcb58");
-
-			vector<string_view> bytes = split(line.substr(match.size(), line.size() - match.size() - 2), ",");
-			for (string_view byte : bytes) {
-				CHECK(byte == "0");
-			}
+			REQUIRE(i + 1 < lines.size());
+			CHECK(
+				lines[i + 1] ==
+				"constexpr std::span<const std::uint8_t, 1048576> "
+				"_30e14955ebf1352266dc2ff8067e68104607e750abb9d3b36582b8af909fcb58"
+				"{_30e14955ebf1352266dc2ff8067e68104607e750abb9d3b36582b8af909fcb58_zeros};"
+			);
 
 			break;
 		}
 	}
+	CHECK(inject_file.find("0,0") == string::npos);
 
 	for (; i < lines.size(); ++i) {
 		auto [match, filename, digest] = match_usage(lines[i]);
@@ -166,3 +186,993 @@ TEST_CASE("Inject <complex filename>") {
 
 	FAIL("Usage line was not found");
 }
+
+TEST_CASE("Decimal encoders") {
+	vector<uint8_t> data;
+	for (int repeat = 0; repeat < 3; ++repeat) {
+		for (int byte = 0; byte < 256; ++byte) data.push_back(static_cast<uint8_t>(byte));
+	}
+
+	mt19937 engine(42);
+	uniform_int_distribution<int> distribution(0, 255);
+	for (int i = 0; i < 1000; ++i) data.push_back(static_cast<uint8_t>(distribution(engine)));
+
+	string expected;
+	for (uint8_t byte : data) expected += "," + to_string(byte);
+
+	vector<pair<string_view, decimal_encoder_t>> encoders = {{"scalar", encode_decimal_scalar}};
+#if SYRINGE_X86
+	if (cpu_supports(cpu_feature::sse41)) encoders.emplace_back("sse4.1", encode_decimal_sse41);
+	if (cpu_supports(cpu_feature::avx2)) encoders.emplace_back("avx2", encode_decimal_avx2);
+#endif
+
+	for (auto [name, encoder] : encoders) {
+		CAPTURE(name);
+
+		// Every length up to a few SIMD blocks exercises the scalar tails
+		for (size_t size = 0; size <= 100; ++size) {
+			string actual(decimal_size_bound(size), '\0');
+			actual.resize(encoder({data.data(), size}, actual.data()) - actual.data());
+
+			size_t expected_size = 0;
+			for (size_t i = 0; i < size; ++i) expected_size += 1 + to_string(data[i]).size();
+			CHECK(actual == expected.substr(0, expected_size));
+		}
+
+		string actual(decimal_size_bound(data.size()), '\0');
+		actual.resize(encoder(data, actual.data()) - actual.data());
+		CHECK(actual == expected);
+	}
+}
+
+TEST_CASE("Inject duplicate files") {
+	string inject_file = syringe({
+		.paths = {{"data/abc.txt", "abc.txt"}, {"./data/abc.txt", "abc-copy.txt"}},
+		.namespace_name = "",
+		.variable_name = "resources",
+	});
+	vector<string_view> lines = split(inject_file, "\n");
+	size_t definition_count = 0;
+	vector<string_view> usage_names;
+
+	for (string_view line : lines) {
+		if (match_definition(line)) ++definition_count;
+
+		auto [match, filename, digest] = match_usage(line);
+		if (match) {
+			CHECK(digest == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+			usage_names.push_back(filename);
+		}
+	}
+
+	CHECK(definition_count == 1);
+	CHECK(usage_names.size() == 2);
+}
+
+TEST_CASE("Streamed output") {
+	InputConfig config{
+		.paths = {{"data/abc.txt", "abc.txt"}, {"data/1MiB_null.bin", "1MiB_null.bin"}},
+		.namespace_name = "my::assets",
+		.variable_name = "resources",
+	};
+	string expected = syringe(config);
+
+	FILE* fp = tmpfile();
+	REQUIRE(fp != nullptr);
+	syringe(config, fp);
+
+	string actual(static_cast<size_t>(ftell(fp)), '\0');
+	rewind(fp);
+	CHECK(fread(actual.data(), 1, actual.size(), fp) == actual.size());
+	fclose(fp);
+
+	CHECK(actual == expected);
+
+	// Unbuffered encoding of large files produces the same text as buffered encoding
+	string jpg_path = "data/René Magritte - Ceci n'est pas une pipe 🚬.jpg";
+	string streamed;
+	string_writer out(streamed);
+	input_file file(jpg_path);
+	write_file_data(out, file);
+	CHECK(streamed == read_file(jpg_path).cpp_data);
+}
+
+TEST_CASE("Parallel output matches sequential output") {
+	InputConfig config{
+		.paths =
+			{
+				{"data/abc.txt", "abc.txt"},
+				{"./data/abc.txt", "abc-copy.txt"},
+				{"data/empty.txt", "empty.txt"},
+				{"data/1MiB_null.bin", "1MiB_null.bin"},
+				{"data/René Magritte - Ceci n'est pas une pipe 🚬.jpg", "pipe.jpg"},
+			},
+		.namespace_name = "",
+		.variable_name = "resources",
+		.jobs = 1,
+	};
+	string expected = syringe(config);
+
+	for (unsigned jobs : {2u, 3u, 8u}) {
+		CAPTURE(jobs);
+		config.jobs = jobs;
+		CHECK(syringe(config) == expected);
+	}
+}
+
+TEST_CASE("Batched reading of small files") {
+	vector<string> paths = {"data/abc.txt", "data/empty.txt", "data/1MiB_null.bin", "data/nonexistent.txt"};
+	vector<const string*> path_pointers;
+	for (const string& path : paths) path_pointers.push_back(&path);
+
+	file_batch_t batch = read_small_files(path_pointers);
+	REQUIRE(batch.contents.size() == paths.size());
+
+	// Files that are too large or failed to open are left to the synchronous reader
+	CHECK_FALSE(batch.contents[2].has_value());
+	CHECK_FALSE(batch.contents[3].has_value());
+
+	for (size_t i = 0; i < 2; ++i) {
+		if (not batch.contents[i]) continue;  // No batched I/O on this system
+
+		input_file file(paths[i]);
+		CHECK(ranges::equal(*batch.contents[i], file.data()));
+	}
+}
+
+#ifndef _WIN32
+TEST_CASE("Batched reading does not open non-regular files") {
+	filesystem::path path = filesystem::temp_directory_path() / "syringe_fifo";
+	filesystem::remove(path);
+	REQUIRE(mkfifo(path.c_str(), 0600) == 0);
+
+	// The writer can only write once, to the reader that the synchronous reader opens
+	std::thread writer([&] {
+		FILE* fp = fopen(path.c_str(), "wb");
+		if (fp == nullptr) return;
+		fputs("abc", fp);
+		fclose(fp);
+	});
+
+	auto result = std::async(std::launch::async, [&] {
+		return syringe({.paths = {{path.string(), "fifo"}}, .namespace_name = "", .variable_name = "resources"});
+	});
+	bool finished = result.wait_for(10s) == std::future_status::ready;
+	CHECK(finished);
+	if (not finished) {
+		// Unblock a reader that is left waiting for another writer
+		FILE* fp = fopen(path.c_str(), "wb");
+		if (fp != nullptr) fclose(fp);
+	}
+
+	writer.join();
+	CHECK(result.get().find("{97,98,99}") != string::npos);
+	filesystem::remove(path);
+}
+#endif
+
+#ifdef __linux__
+TEST_CASE("Pseudo-files of size 0 are read") {
+	string path = "/proc/version";
+	REQUIRE(filesystem::file_size(path) == 0);
+
+	ifstream stream(path, ios::binary);
+	string contents{istreambuf_iterator<char>(stream), istreambuf_iterator<char>()};
+	REQUIRE_FALSE(contents.empty());
+
+	file_data_t data = read_file(path);
+	CHECK(data.size == contents.size());
+	span<const uint8_t> bytes(reinterpret_cast<const uint8_t*>(contents.data()), contents.size());
+	CHECK(data.cpp_data == read_file(bytes).cpp_data);
+
+	// The batched reader leaves them to the synchronous reader
+	vector<const string*> path_pointers = {&path};
+	CHECK_FALSE(read_small_files(path_pointers).contents[0].has_value());
+}
+#endif
+
+TEST_CASE("Memory-mapped output") {
+	InputConfig config{
+		.paths =
+			{
+				{"data/abc.txt", "abc.txt"},
+				{"./data/abc.txt", "abc-copy.txt"},
+				{"data/empty.txt", "empty.txt"},
+				{"data/1MiB_null.bin", "1MiB_null.bin"},
+			},
+		.namespace_name = "my::assets",
+		.variable_name = "resources",
+		.jobs = 2,
+	};
+	string expected = syringe(config);
+
+	string path = (filesystem::temp_directory_path() / "syringe_mapped_output.hpp").string();
+	syringe_mapped(config, path);
+
+	FILE* fp = fopen(path.c_str(), "rb");
+	REQUIRE(fp != nullptr);
+	string actual(expected.size() + 1, '\0');
+	actual.resize(fread(actual.data(), 1, actual.size(), fp));
+	fclose(fp);
+	filesystem::remove(path);
+
+	CHECK(actual == expected);
+
+	// Encoding into a preallocated region writes exactly the encoded size
+	vector<uint8_t> data = {0, 9, 10, 99, 100, 255, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17};
+	string region(decimal_size(data) - 1, '\0');
+	region.push_back('#');
+	char* end = encode_decimal_list(data, region.data());
+	CHECK(end == region.data() + region.size() - 1);
+	CHECK(region.back() == '#');
+	CHECK(region.substr(0, region.size() - 1) == read_file(data).cpp_data);
+}
+
+TEST_CASE("Wrapped output") {
+	InputConfig config{
+		.paths =
+			{
+				{"data/abc.txt", "abc.txt"},
+				{"data/empty.txt", "empty.txt"},
+				{"data/René Magritte - Ceci n'est pas une pipe 🚬.jpg", "pipe.jpg"},
+			},
+		.namespace_name = "",
+		.variable_name = "resources",
+		.wrap = 16,
+	};
+	string result = syringe(config);
+
+	CHECK(
+		result.find(
+			"constexpr std::array<std::uint8_t, 3> "
+			"_ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad = {\n\t 97, 98, 99,\n};"
+		) != string::npos
+	);
+	CHECK(
+		result.find(
+			"constexpr std::array<std::uint8_t, 0> "
+			"_e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855 = {\n};"
+		) != string::npos
+	);
+
+	// Every full line of a large file has the same length
+	size_t full_lines = 0;
+	string_view definitions = string_view(result).substr(result.find("#endif  // SYRINGE_RUNTIME_HPP"));
+	for (string_view line : split(definitions, "\n")) {
+		if (line.starts_with("\t") and line.size() == 1 + 4 * 16) ++full_lines;
+	}
+	CHECK(full_lines == 1003514 / 16);
+
+	string path = (filesystem::temp_directory_path() / "syringe_wrapped_output.hpp").string();
+	syringe_mapped(config, path);
+	FILE* fp = fopen(path.c_str(), "rb");
+	REQUIRE(fp != nullptr);
+	string mapped(result.size() + 1, '\0');
+	mapped.resize(fread(mapped.data(), 1, mapped.size(), fp));
+	fclose(fp);
+	filesystem::remove(path);
+	CHECK(mapped == result);
+
+	// Lines are broken at the same places when data is encoded in blocks
+	vector<uint8_t> data(100);
+	for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<uint8_t>(i * 7);
+	string whole;
+	encode_decimal_wrapped(data, 7, 0, whole);
+	string blocks;
+	encode_decimal_wrapped(span(data).first(45), 7, 0, blocks);
+	encode_decimal_wrapped(span(data).subspan(45), 7, 45, blocks);
+	CHECK(blocks == whole);
+	CHECK(whole.size() == wrapped_size(data.size(), 7));
+}
+
+TEST_CASE("Output does not depend on input order") {
+	vector<pair<string, string>> paths = {
+		{"data/abc.txt", "b/abc.txt"},
+		{"data/empty.txt", "empty.txt"},
+		{"./data/abc.txt", "a/abc.txt"},
+		{"data/1MiB_null.bin", "1MiB_null.bin"},
+		{"data/René Magritte - Ceci n'est pas une pipe 🚬.jpg", "pipe.jpg"},
+	};
+
+	InputConfig config{.namespace_name = "", .variable_name = "resources"};
+	for (const auto& path : paths) config.paths.insert(path);
+	string expected = syringe(config);
+
+	// Insert in a different order and with a different bucket count, which changes the iteration order
+	InputConfig reordered{.namespace_name = "", .variable_name = "resources"};
+	reordered.paths.reserve(1000);
+	for (const auto& path : paths | views::reverse) reordered.paths.insert(path);
+	CHECK(syringe(reordered) == expected);
+
+	// Usages are sorted by display path, definitions follow the order of their first usage
+	vector<string> display_paths;
+	vector<string> usage_hashes;
+	vector<string> definition_hashes;
+	for (string_view line : split(expected, "\n")) {
+		if (auto [match, filename, digest] = match_usage(line); match) {
+			display_paths.push_back(filename.str());
+			usage_hashes.push_back(digest.str());
+		}
+		if (auto [match, size, digest] = match_definition_until_data(line); match) {
+			definition_hashes.push_back(digest.str());
+		}
+		if (auto [match, digest, size] = match_zeros_definition(line); match) {
+			definition_hashes.push_back(digest.str());
+		}
+	}
+
+	CHECK(display_paths == vector<string>{"1MiB_null.bin", "a/abc.txt", "b/abc.txt", "empty.txt", "pipe.jpg"});
+	usage_hashes.erase(unique(usage_hashes.begin(), usage_hashes.end()), usage_hashes.end());
+	CHECK(definition_hashes == usage_hashes);
+}
+
+TEST_CASE("Output is replaced only if changed") {
+	InputConfig config{.paths = {{"data/abc.txt", "abc.txt"}}, .namespace_name = "", .variable_name = "resources"};
+	filesystem::path path = filesystem::temp_directory_path() / "syringe_if_changed.hpp";
+	filesystem::remove(path);
+
+	syringe_if_changed(config, path.string(), false);
+	REQUIRE(filesystem::exists(path));
+	auto first_time = filesystem::last_write_time(path);
+
+	// Same contents: the file is left untouched
+	filesystem::last_write_time(path, first_time - 1h);
+	syringe_if_changed(config, path.string(), true);
+	CHECK(filesystem::last_write_time(path) == first_time - 1h);
+
+	// Different contents: the file is replaced
+	config.paths.insert({"data/empty.txt", "empty.txt"});
+	syringe_if_changed(config, path.string(), false);
+	CHECK(filesystem::last_write_time(path) != first_time - 1h);
+	CHECK(same_file_contents(path.string(), path.string()));
+
+	FILE* fp = fopen(path.string().c_str(), "rb");
+	REQUIRE(fp != nullptr);
+	string expected = syringe(config);
+	string actual(expected.size() + 1, '\0');
+	actual.resize(fread(actual.data(), 1, actual.size(), fp));
+	fclose(fp);
+	filesystem::remove(path);
+	CHECK(actual == expected);
+
+	// No temporary files are left behind
+	for (const auto& entry : filesystem::directory_iterator(filesystem::temp_directory_path())) {
+		CHECK_FALSE(entry.path().filename().string().starts_with("syringe_if_changed.hpp."));
+	}
+}
+
+/// Decode the contents of string literal chunks produced by `encode_string`.
+vector<uint8_t> decode_string_chunks(string_view text) {
+	vector<uint8_t> result;
+
+	for (string_view line : split(text, "\n")) {
+		if (line.empty()) continue;
+		REQUIRE(line.starts_with("\t\""));
+		REQUIRE(line.ends_with("\""));
+		line = line.substr(2, line.size() - 3);
+
+		for (size_t i = 0; i < line.size(); ++i) {
+			if (line[i] != '\\') {
+				result.push_back(static_cast<uint8_t>(line[i]));
+				continue;
+			}
+
+			char c = line[++i];
+			if (c >= '0' and c <= '7') {
+				int value = 0;
+				for (int digits = 0; digits < 3 and i < line.size() and line[i] >= '0' and line[i] <= '7'; ++digits) {
+					value = value * 8 + (line[i++] - '0');
+				}
+				--i;
+				result.push_back(static_cast<uint8_t>(value));
+				continue;
+			}
+
+			constexpr string_view escapes = "abfnrtv";
+			constexpr string_view values = "\a\b\f\n\r\t\v";
+			result.push_back(static_cast<uint8_t>(escapes.find(c) == string_view::npos ? c : values[escapes.find(c)]));
+		}
+	}
+
+	return result;
+}
+
+TEST_CASE("String encoding") {
+	auto encode = [](string_view text) {
+		string result;
+		encode_string({reinterpret_cast<const uint8_t*>(text.data()), text.size()}, 0, result);
+		return result;
+	};
+
+	CHECK(encode("") == "");
+	CHECK(encode("abc") == "\n\t\"abc\"");
+	CHECK(encode(string_view("\0a\0""1\08", 6)) == "\n\t\"\\0a\\0001\\08\"");
+	CHECK(encode("\"\\\n\x7f\xff") == "\n\t\"\\\"\\\\\\n\\177\\377\"");
+	CHECK(encode("???") == "\n\t\"?\\?\\?\"");
+
+	mt19937 engine(42);
+	uniform_int_distribution<int> distribution(0, 255);
+	vector<uint8_t> data(1000);
+	for (auto& byte : data) byte = static_cast<uint8_t>(distribution(engine) % 2 ? distribution(engine) : '0');
+
+	for (size_t size : {0, 1, 63, 64, 65, 200, 1000}) {
+		CAPTURE(size);
+		span<const uint8_t> input(data.data(), size);
+
+		string whole;
+		encode_string(input, 0, whole);
+		CHECK(whole.size() == string_size(input, 0));
+		CHECK(decode_string_chunks(whole) == vector<uint8_t>(input.begin(), input.end()));
+
+		// Blocks that begin at chunk boundaries produce the same text
+		string blocks;
+		size_t split_at = min<size_t>(size, 2 * string_chunk_size);
+		encode_string(input.first(split_at), 0, blocks);
+		encode_string(input.subspan(split_at), split_at, blocks);
+		CHECK(blocks == whole);
+	}
+
+	string result = syringe({
+		.paths = {{"data/abc.txt", "abc.txt"}, {"data/empty.txt", "empty.txt"}},
+		.namespace_name = "",
+		.variable_name = "resources",
+		.encoding = encoding_t::string,
+	});
+	string abc = "_ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+	string empty = "_e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855";
+	CHECK(
+		result.find(
+			"constexpr std::uint8_t " + abc + "_data[3 + 1] = {\n\t\"abc\"\n};\n" +
+			"constexpr std::span<const std::uint8_t, 3> " + abc + "{" + abc + "_data, 3};"
+		) != string::npos
+	);
+	CHECK(result.find("constexpr std::uint8_t " + empty + "_data[0 + 1] = {\n};") != string::npos);
+}
+
+TEST_CASE("Embed encoding") {
+	string result = syringe({
+		.paths = {{"data/abc.txt", "abc.txt"}},
+		.namespace_name = "",
+		.variable_name = "resources",
+		.encoding = encoding_t::embed,
+	});
+
+	string path = filesystem::absolute("data/abc.txt").generic_string();
+	string hash = "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+	CHECK(
+		result.find(
+			"#if defined(__has_embed)\n"
+			"#if __has_embed(\"" + path + "\")\n"
+			"constexpr std::array<std::uint8_t, 3> _" + hash + " = {\n"
+			"#embed \"" + path + "\"\n"
+			"};\n"
+			"#define SYRINGE_EMBEDDED_" + hash + "\n"
+			"#endif\n"
+			"#endif\n"
+			"#ifndef SYRINGE_EMBEDDED_" + hash + "\n"
+			"constexpr std::array<std::uint8_t, 3> _" + hash + " = {97,98,99};\n"
+			"#endif\n"
+			"#undef SYRINGE_EMBEDDED_" + hash + "\n"
+		) != string::npos
+	);
+}
+
+TEST_CASE("Incbin encoding") {
+	filesystem::path assembly_path = filesystem::temp_directory_path() / "syringe_incbin.S";
+	filesystem::path mapped_path = filesystem::temp_directory_path() / "syringe_incbin.hpp";
+	InputConfig config{
+		.paths = {{"data/abc.txt", "abc.txt"}},
+		.namespace_name = "",
+		.variable_name = "resources",
+		.encoding = encoding_t::incbin,
+		.assembly_path = assembly_path.string(),
+	};
+
+	auto read_text = [](const filesystem::path& path) {
+		FILE* fp = fopen(path.string().c_str(), "rb");
+		REQUIRE(fp != nullptr);
+		string result(filesystem::file_size(path), '\0');
+		result.resize(fread(result.data(), 1, result.size(), fp));
+		fclose(fp);
+		return result;
+	};
+
+	string result = syringe(config);
+	string hash = "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+	CHECK(
+		result.find(
+			"extern \"C\" const std::uint8_t syringe_" + hash + "[];\n"
+			"constexpr std::span<const std::uint8_t, 3> _" + hash + "{syringe_" + hash + ", 3};"
+		) != string::npos
+	);
+
+	string assembly = read_text(assembly_path);
+	string path = filesystem::absolute("data/abc.txt").generic_string();
+	CHECK(assembly.find("SYRINGE_SYMBOL(syringe_" + hash + "):\n") != string::npos);
+	CHECK(assembly.find(".incbin \"" + path + "\"\n") != string::npos);
+
+	// Memory-mapped output writes the same header and assembly file
+	filesystem::remove(assembly_path);
+	syringe_mapped(config, mapped_path.string());
+	CHECK(read_text(mapped_path) == result);
+	CHECK(read_text(assembly_path) == assembly);
+
+	filesystem::remove(assembly_path);
+	filesystem::remove(mapped_path);
+}
+
+TEST_CASE("Object encoding") {
+	filesystem::path object_path = filesystem::temp_directory_path() / "syringe_object.o";
+	InputConfig config{
+		.paths = {{"data/abc.txt", "abc.txt"}, {"data/empty.txt", "empty.txt"}, {"./data/abc.txt", "abc-copy.txt"}},
+		.namespace_name = "",
+		.variable_name = "resources",
+		.encoding = encoding_t::object,
+		.object_path = object_path.string(),
+	};
+
+	string result = syringe(config);
+	string hash = "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+	CHECK(
+		result.find(
+			"extern \"C\" const std::uint8_t syringe_" + hash + "[];\n"
+			"constexpr std::span<const std::uint8_t, 3> _" + hash + "{syringe_" + hash + ", 3};"
+		) != string::npos
+	);
+
+	FILE* fp = fopen(object_path.string().c_str(), "rb");
+	REQUIRE(fp != nullptr);
+	string object(filesystem::file_size(object_path), '\0');
+	object.resize(fread(object.data(), 1, object.size(), fp));
+	fclose(fp);
+	filesystem::remove(object_path);
+
+	elf::header_t header;
+	REQUIRE(object.size() >= sizeof(header));
+	memcpy(&header, object.data(), sizeof(header));
+	CHECK(string_view(reinterpret_cast<const char*>(header.ident), 4) == "\x7f" "ELF");
+	CHECK(header.type == elf::et_rel);
+	REQUIRE(header.shoff + header.shnum * sizeof(elf::section_t) == object.size());
+
+	// Null, string table, symbol table, stack note, then a group and a data section for each of the 2 unique files
+	REQUIRE(header.shnum == 8);
+	vector<elf::section_t> sections(header.shnum);
+	memcpy(sections.data(), object.data() + header.shoff, sections.size() * sizeof(elf::section_t));
+	auto section_name = [&](const elf::section_t& section) {
+		return string(object.data() + sections[header.shstrndx].offset + section.name);
+	};
+
+	CHECK(section_name(sections[5]) == ".rodata.syringe_" + hash);
+	CHECK(sections[5].offset % 64 == 0);
+	CHECK(object.substr(sections[5].offset, sections[5].size) == "abc");
+	CHECK(sections[7].size == 0);
+
+	elf::symbol_t symbol;
+	memcpy(&symbol, object.data() + sections[2].offset + sizeof(symbol), sizeof(symbol));
+	CHECK(string(object.data() + sections[1].offset + symbol.name) == "syringe_" + hash);
+	CHECK(symbol.shndx == 5);
+	CHECK(symbol.size == 3);
+	CHECK(header.machine == elf::host_machine);
+
+	// Objects for another machine differ only in the header
+	config.object_machine = elf::em_aarch64;
+	CHECK(syringe(config) == result);
+	fp = fopen(object_path.string().c_str(), "rb");
+	REQUIRE(fp != nullptr);
+	string cross_object(object.size(), '\0');
+	cross_object.resize(fread(cross_object.data(), 1, cross_object.size(), fp));
+	fclose(fp);
+	filesystem::remove(object_path);
+
+	memcpy(&header, cross_object.data(), sizeof(header));
+	CHECK(header.machine == elf::em_aarch64);
+	CHECK(cross_object.substr(sizeof(header)) == object.substr(sizeof(header)));
+}
+
+TEST_CASE("Word encoding") {
+	InputConfig config{
+		.paths = {{"data/abc.txt", "abc.txt"}, {"data/empty.txt", "empty.txt"}},
+		.namespace_name = "",
+		.variable_name = "resources",
+		.encoding = encoding_t::words,
+	};
+	string result = syringe(config);
+
+	// Definitions are only usable at runtime, apart from constexpr definitions of the same file in other headers
+	string name = "words_ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+	CHECK(
+		result.find(
+			"#ifndef SYRINGE_FILE_" + name + "\n#define SYRINGE_FILE_" + name + "\n"
+			"constexpr word_bytes<3> _" + name + "_words{{0x0000000000636261}};\n"
+			"const std::span<const std::uint8_t, 3> _" + name + " = _" + name + "_words.span();"
+		) != string::npos
+	);
+	CHECK(result.find("{\"abc.txt\", syringe::_" + name + "}") != string::npos);
+	CHECK(result.find("struct word_bytes") != string::npos);
+	string map_type = "syringe::cxmap<std::string_view, std::span<const std::uint8_t>, 2>";
+	CHECK(result.find("\nconst " + map_type + " resources{") != string::npos);
+
+	// Blocks that split words encode the same as complete data
+	vector<uint8_t> data(1000);
+	iota(data.begin(), data.end(), uint8_t(0));
+	string expected(words_size(data.size()), '\0');
+	CHECK(encode_words(data, expected.data()) == expected.data() + expected.size());
+	CHECK(expected.starts_with("0x0706050403020100,0x0f0e0d0c0b0a0908,"));
+
+	for (size_t block_size : {1, 3, 8, 13, 64, 999}) {
+		literal_encoder encoder(config);
+		string actual;
+		for (size_t offset = 0; offset < data.size(); offset += block_size) {
+			encoder.encode(span(data).subspan(offset, min(block_size, data.size() - offset)), actual);
+		}
+		encoder.finish(actual);
+
+		CHECK(actual == expected);
+		CHECK(encoder.size() == expected.size());
+	}
+}
+
+TEST_CASE("Blob layout") {
+	InputConfig config{
+		.paths = {{"data/abc.txt", "b.txt"}, {"data/empty.txt", "c.txt"}, {"./data/abc.txt", "a.txt"}},
+		.namespace_name = "",
+		.variable_name = "resources",
+		.blob = true,
+	};
+	string result = syringe(config);
+
+	CHECK(result.find("alignas(64) constexpr std::uint8_t _resources_blob[] = {0,97,98,99\n};") != string::npos);
+	CHECK(result.find("constexpr char _resources_keys[1][2048] = {\n\t\"a.txtb.txtc.txt\",\n};") != string::npos);
+	CHECK(
+		result.find(
+			"constexpr blob_entry<std::uint32_t> _resources_index[3] = {\n"
+			"\t{0, 5, 1, 3},\n"
+			"\t{5, 5, 1, 3},\n"
+			"\t{10, 5, 4, 0},\n"
+			"};"
+		) != string::npos
+	);
+	CHECK(result.ends_with(
+		"constexpr syringe::blob_map<3, syringe::_resources_index, syringe::_resources_keys, syringe::_resources_blob> "
+		"resources{};\n"
+	));
+
+	config.encoding = encoding_t::string;
+	CHECK(syringe(config).find("_resources_blob[] = {\"\\0\"\n\t\"abc\"\n};") != string::npos);
+
+	// Memory-mapped output lays out the blob the same way
+	config.wrap = 2;
+	config.encoding = encoding_t::decimal;
+	string path = (filesystem::temp_directory_path() / "syringe_blob.hpp").string();
+	syringe_mapped(config, path);
+
+	FILE* fp = fopen(path.c_str(), "rb");
+	REQUIRE(fp != nullptr);
+	string expected = syringe(config);
+	string actual(expected.size() + 1, '\0');
+	actual.resize(fread(actual.data(), 1, actual.size(), fp));
+	fclose(fp);
+	filesystem::remove(path);
+
+	CHECK(actual == expected);
+	CHECK(expected.find("_resources_blob[] = {0,\n\t 97, 98,\n\t 99,\n};") != string::npos);
+
+	// Helper arrays are named after the qualified variable, so that maps in other namespaces can be included with it
+	config.namespace_name = "my::assets";
+	string qualified = syringe(config);
+	CHECK(qualified.find("constexpr std::uint8_t _my_assets_resources_blob[]") != string::npos);
+	CHECK(qualified.find("constexpr char _my_assets_resources_keys[1][2048]") != string::npos);
+	CHECK(qualified.find("syringe::blob_map<3, syringe::_my_assets_resources_index, ") != string::npos);
+}
+
+TEST_CASE("Small file pool") {
+	InputConfig config{
+		.paths =
+			{
+				{"data/abc.txt", "abc.txt"},
+				{"./data/abc.txt", "abc-copy.txt"},
+				{"data/empty.txt", "empty.txt"},
+				{"data/1MiB_null.bin", "1MiB_null.bin"},
+			},
+		.namespace_name = "",
+		.variable_name = "resources",
+		.pool_below = 16,
+	};
+	string result = syringe(config);
+
+	string abc_hash = "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+	string empty_hash = "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855";
+	CHECK(
+		result.find(
+			"\nalignas(64) constexpr std::uint8_t _resources_pool[] = {0,97,98,99\n};\n"
+			"#ifndef SYRINGE_FILE_" + abc_hash + "\n#define SYRINGE_FILE_" + abc_hash + "\n"
+			"constexpr std::span<const std::uint8_t, 3> _" + abc_hash + "{_resources_pool + 1, 3};\n#endif\n"
+		) != string::npos
+	);
+	CHECK(result.find("std::uint8_t, 0> _" + empty_hash + "{_resources_pool + 4, 0};\n") != string::npos);
+	CHECK(result.find("std::array<std::uint8_t, 3>") == string::npos);
+	CHECK(result.find("_zeros[1048576]{};") != string::npos);
+	CHECK(result.find("\t{\"abc-copy.txt\", syringe::_" + abc_hash + "},") != string::npos);
+
+	// Memory-mapped output places the pool the same way
+	config.encoding = encoding_t::string;
+	string path = (filesystem::temp_directory_path() / "syringe_pool.hpp").string();
+	syringe_mapped(config, path);
+
+	FILE* fp = fopen(path.c_str(), "rb");
+	REQUIRE(fp != nullptr);
+	string expected = syringe(config);
+	string actual(expected.size() + 1, '\0');
+	actual.resize(fread(actual.data(), 1, actual.size(), fp));
+	fclose(fp);
+	filesystem::remove(path);
+
+	CHECK(actual == expected);
+	CHECK(expected.find("_resources_pool[] = {\"\\0\"\n\t\"abc\"\n};") != string::npos);
+
+	config.namespace_name = "assets";
+	CHECK(syringe(config).find("constexpr std::uint8_t _assets_resources_pool[]") != string::npos);
+}
+
+TEST_CASE("External files above a size") {
+	filesystem::path assembly_path = filesystem::temp_directory_path() / "syringe_external.S";
+	filesystem::path mapped_path = filesystem::temp_directory_path() / "syringe_external.hpp";
+	string jpeg_path = "data/René Magritte - Ceci n'est pas une pipe 🚬.jpg";
+	InputConfig config{
+		.paths = {{"data/abc.txt", "abc.txt"}, {jpeg_path, "pipe.jpg"}},
+		.namespace_name = "",
+		.variable_name = "resources",
+		.assembly_path = assembly_path.string(),
+		.external_above = 1024,
+	};
+
+	auto read_text = [](const filesystem::path& path) {
+		FILE* fp = fopen(path.string().c_str(), "rb");
+		REQUIRE(fp != nullptr);
+		string result(filesystem::file_size(path), '\0');
+		result.resize(fread(result.data(), 1, result.size(), fp));
+		fclose(fp);
+		return result;
+	};
+
+	// Small files keep their encoding, large files are declared in the header and defined in the assembly file
+	string result = syringe(config);
+	string abc_hash = "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+	string jpeg_hash = read_file(jpeg_path).hash;
+	CHECK(result.find("constexpr std::array<std::uint8_t, 3> _" + abc_hash + " = {97,98,99};") != string::npos);
+	CHECK(result.find("extern \"C\" const std::uint8_t syringe_" + jpeg_hash + "[];") != string::npos);
+	CHECK(result.find("\t{\"pipe.jpg\", syringe::_" + jpeg_hash + "},") != string::npos);
+
+	string assembly = read_text(assembly_path);
+	CHECK(assembly.find("SYRINGE_SYMBOL(syringe_" + jpeg_hash + "):\n") != string::npos);
+	CHECK(assembly.find(abc_hash) == string::npos);
+
+	filesystem::remove(assembly_path);
+	syringe_mapped(config, mapped_path.string());
+	CHECK(read_text(mapped_path) == result);
+	CHECK(read_text(assembly_path) == assembly);
+
+	filesystem::remove(assembly_path);
+	filesystem::remove(mapped_path);
+}
+
+TEST_CASE("Automatic encoding") {
+	// Built-in estimates: decimal has less overhead per file, string compiles faster per byte
+	calibration_t defaults = default_calibration("GNU");
+	CHECK(defaults.choose(3) == encoding_t::decimal);
+	CHECK(defaults.choose(1024 * 1024) == encoding_t::string);
+	CHECK(default_calibration("MSVC").choose(1024 * 1024) == encoding_t::decimal);
+
+	string jpeg_path = "data/René Magritte - Ceci n'est pas une pipe 🚬.jpg";
+	InputConfig config{
+		.paths = {{"data/abc.txt", "abc.txt"}, {jpeg_path, "pipe.jpg"}},
+		.namespace_name = "",
+		.variable_name = "resources",
+		.encoding = encoding_t::automatic,
+		.compiler_id = "GNU",
+	};
+	string result = syringe(config);
+	string abc_hash = "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+	string jpeg_hash = read_file(jpeg_path).hash;
+	CHECK(result.find("constexpr std::array<std::uint8_t, 3> _" + abc_hash + " = {97,98,99};") != string::npos);
+	CHECK(result.find("constexpr std::uint8_t _" + jpeg_hash + "_data[1003514 + 1] = {") != string::npos);
+
+	string path = (filesystem::temp_directory_path() / "syringe_automatic.hpp").string();
+	syringe_mapped(config, path);
+	FILE* fp = fopen(path.c_str(), "rb");
+	REQUIRE(fp != nullptr);
+	string actual(result.size() + 1, '\0');
+	actual.resize(fread(actual.data(), 1, actual.size(), fp));
+	fclose(fp);
+	CHECK(actual == result);
+
+	// A calibration table is looked up by compiler id and version, and encodings missing from it are not used
+	fp = fopen(path.c_str(), "wb");
+	REQUIRE(fp != nullptr);
+	fputs(
+		"# Calibration\n"
+		"GNU 12 decimal 0.5 1.0\n"
+		"GNU 12 embed 0.5 0.5\n"
+		"\n"
+		"GNU 13 decimal 0.5 1.0\n"
+		"GNU 13 string 0.5 0.1 65535\n",
+		fp
+	);
+	fclose(fp);
+
+	calibration_t gnu_12 = load_calibration(path, "GNU", "12");
+	CHECK(gnu_12.choose(1024 * 1024) == encoding_t::embed);
+	calibration_t gnu_13 = load_calibration(path, "GNU", "13");
+	CHECK(gnu_13.choose(65535) == encoding_t::string);
+	CHECK(gnu_13.choose(65536) == encoding_t::decimal);
+	CHECK(load_calibration(path, "GNU", "14").choose(65535) == encoding_t::string);
+	CHECK(load_calibration(path, "Clang", "18").choose(1024 * 1024) == encoding_t::string);
+
+	fp = fopen(path.c_str(), "wb");
+	REQUIRE(fp != nullptr);
+	fputs("GNU 12 words 0.5 1.0\n", fp);
+	fclose(fp);
+	CHECK_THROWS(load_calibration(path, "GNU", "12"));
+	filesystem::remove(path);
+}
+
+TEST_CASE("Runtime header") {
+	InputConfig config{
+		.paths = {{"data/abc.txt", "abc.txt"}},
+		.namespace_name = "",
+		.variable_name = "resources",
+	};
+
+	// The runtime is written into the output by default, behind an include guard
+	string runtime = runtime_header();
+	CHECK(runtime.starts_with("#ifndef SYRINGE_RUNTIME_HPP\n#define SYRINGE_RUNTIME_HPP\n"));
+	CHECK(runtime.find("class cxmap") != string::npos);
+	CHECK(runtime.find("class blob_map") != string::npos);
+	CHECK(syringe(config).starts_with("#pragma once\n" + runtime + "\nnamespace syringe {\n"));
+
+	config.runtime_header = "syringe/runtime.hpp";
+	string result = syringe(config);
+	CHECK(result.starts_with("#pragma once\n#include <syringe/runtime.hpp>\n\nnamespace syringe {\n"));
+	CHECK(result.find("class cxmap") == string::npos);
+
+	// Definitions are guarded, so that several generated headers with the same file can be included together
+	string hash = "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+	CHECK(
+		result.find(
+			"#ifndef SYRINGE_FILE_" + hash + "\n#define SYRINGE_FILE_" + hash + "\n"
+			"constexpr std::array<std::uint8_t, 3> _" + hash + " = {97,98,99};\n#endif"
+		) != string::npos
+	);
+}
+
+TEST_CASE("Lite runtime") {
+	InputConfig config{
+		.paths = {{"data/abc.txt", "abc.txt"}, {"data/1MiB_null.bin", "1MiB_null.bin"}},
+		.namespace_name = "",
+		.variable_name = "resources",
+		.lite = true,
+	};
+
+	// The lite runtime includes no standard headers besides the ones of the resource map's key and value types
+	string runtime = runtime_header(true);
+	CHECK(
+		runtime.starts_with("#ifndef SYRINGE_LITE_RUNTIME_HPP\n#define SYRINGE_LITE_RUNTIME_HPP\n"
+							"#include <cstddef>\n#include <cstdint>\n#include <span>\n#include <string_view>\n\n")
+	);
+	CHECK(runtime.find("#include", runtime.find("<string_view>")) == string::npos);
+	CHECK(runtime.find("class lite_cxmap") != string::npos);
+
+	string result = syringe(config);
+	CHECK(result.starts_with("#pragma once\n" + runtime + "\nnamespace syringe {\n"));
+	CHECK(result.find("std::array") == string::npos);
+
+	// Contents and zeros are defined in C arrays
+	string hash = "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+	CHECK(
+		result.find(
+			"constexpr std::uint8_t _" + hash + "_data[3 + 1] = {97,98,99\n};\n"
+			"constexpr std::span<const std::uint8_t, 3> _" + hash + "{_" + hash + "_data, 3};"
+		) != string::npos
+	);
+	string null_hash = "30e14955ebf1352266dc2ff8067e68104607e750abb9d3b36582b8af909fcb58";
+	CHECK(result.find("inline std::uint8_t _" + null_hash + "_zeros[1048576]{};") != string::npos);
+
+	// Zeros are the same inline variable in full headers, which other translation units may include
+	config.lite = false;
+	CHECK(syringe(config).find("inline std::uint8_t _" + null_hash + "_zeros[1048576]{};") != string::npos);
+	config.lite = true;
+	CHECK(
+		result.find("constexpr syringe::lite_cxmap<std::string_view, std::span<const std::uint8_t>, 2> resources{")
+		!= string::npos
+	);
+}
+
+TEST_CASE("Declaration-only header") {
+	InputConfig config{
+		.paths = {{"data/abc.txt", "abc.txt"}, {"data/empty.txt", "empty.txt"}},
+		.namespace_name = "assets",
+		.variable_name = "resources",
+		.source_path = "resources.cpp",
+		.source_header = "include/resources.hpp",
+	};
+
+	// The header declares the resource map, the data translation unit includes the header and defines it
+	string header = declaration_header(config);
+	CHECK(header.starts_with("#pragma once\n" + runtime_header() + "\n"));
+	CHECK(header.ends_with(
+		"\nnamespace assets {\n\n"
+		"extern const syringe::cxmap<std::string_view, std::span<const std::uint8_t>, 2> resources;\n\n"
+		"}  // namespace assets\n"
+	));
+
+	string source = syringe(config);
+	CHECK(source.starts_with("#include \"include/resources.hpp\"\n\nnamespace syringe {\n\n"));
+	CHECK(source.find("class cxmap") == string::npos);
+	CHECK(source.find("constexpr syringe::cxmap<std::string_view, std::span<const std::uint8_t>, 2> resources{")
+		  != string::npos);
+
+	// The header does not depend on file contents
+	config.paths = {{"data/1MiB_null.bin", "abc.txt"}, {"data/empty.txt", "empty.txt"}};
+	CHECK(declaration_header(config) == header);
+	CHECK(syringe(config) != source);
+}
+
+TEST_CASE("Shards") {
+	filesystem::path directory = filesystem::temp_directory_path() / "syringe_shards";
+	filesystem::remove_all(directory);
+	filesystem::create_directories(directory);
+
+	InputConfig config{
+		.paths =
+			{{"data/abc.txt", "abc.txt"},
+			 {"data/empty.txt", "empty.txt"},
+			 {"data/1MiB_null.bin", "1MiB_null.bin"},
+			 {"data/René Magritte - Ceci n'est pas une pipe 🚬.jpg", "pipe.jpg"}},
+		.namespace_name = "",
+		.variable_name = "resources",
+		.source_path = (directory / "resources.cpp").string(),
+		.source_header = "resources.hpp",
+		.shards = 3,
+	};
+	CHECK(shard_path("out/resources.cpp", 2) == "out/resources_2.cpp");
+	CHECK(shard_path("out.d/resources", 0) == "out.d/resources_0");
+
+	auto read_text = [](const filesystem::path& path) {
+		FILE* fp = fopen(path.string().c_str(), "rb");
+		REQUIRE(fp != nullptr);
+		string result(filesystem::file_size(path), '\0');
+		result.resize(fread(result.data(), 1, result.size(), fp));
+		fclose(fp);
+		return result;
+	};
+
+	syringe_shards(config);
+	string index = read_text(config.source_path);
+	CHECK(index.starts_with("#include \"resources.hpp\"\n\nnamespace syringe {\n\n"));
+	CHECK(index.find("constexpr syringe::cxmap<std::string_view, std::span<const std::uint8_t>, 4> resources{")
+		  != string::npos);
+
+	// Every file is defined in the shard of its path, with external linkage, and only declared in the index
+	string hash = "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+	string declaration = "extern const std::array<std::uint8_t, 3> _" + hash + ";";
+	CHECK(index.find(declaration) != string::npos);
+	CHECK(index.find("{97,98,99}") == string::npos);
+
+	string shard = read_text(shard_path(config.source_path, shard_of("abc.txt", config.shards)));
+	CHECK(shard.starts_with("#include \"resources.hpp\"\n\nnamespace syringe {\n\n" + declaration + "\n"));
+	CHECK(shard.find("constexpr std::array<std::uint8_t, 3> _" + hash + " = {97,98,99};") != string::npos);
+	CHECK(shard.ends_with("\n\n}  // namespace syringe\n"));
+
+	// Zero files are defined in the index
+	string null_hash = "30e14955ebf1352266dc2ff8067e68104607e750abb9d3b36582b8af909fcb58";
+	CHECK(index.find("_" + null_hash + "_zeros[1048576]{}") != string::npos);
+
+	// Unchanged shards are not replaced
+	filesystem::path first_shard = shard_path(config.source_path, 0);
+	auto first_time = filesystem::last_write_time(first_shard);
+	filesystem::last_write_time(first_shard, first_time - 1h);
+	syringe_shards(config);
+	CHECK(filesystem::last_write_time(first_shard) == first_time - 1h);
+
+	filesystem::remove_all(directory);
+}